@@ -0,0 +1,134 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+    // Routes on demand without preprocessing: Dijkstra runs from both ends,
+    // the backward search over the incoming edges, always advancing the side
+    // with the closer frontier. The search stops once the two frontiers
+    // together are not shorter than the best meeting found so far.
+    template <typename Weight>
+    class BidirectionalRouter : public IRouter<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        explicit BidirectionalRouter(const Graph& graph);
+
+        using typename IRouter<Weight>::RouteInfo;
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    private:
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+        struct Search {
+            using QueueItem = std::pair<Weight, VertexId>;
+
+            explicit Search(size_t vertex_count)
+                : weights(vertex_count)
+                , edges(vertex_count, NO_EDGE)
+            {}
+
+            std::vector<std::optional<Weight>> weights;
+            // the edge the vertex was reached by
+            std::vector<EdgeId> edges;
+            std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        };
+
+        const Graph& graph_;
+        ReverseIncidenceLists<Weight> reverse_incidence_;
+    };
+
+
+    template <typename Weight>
+    BidirectionalRouter<Weight>::BidirectionalRouter(const Graph& graph)
+        : graph_(graph)
+        , reverse_incidence_(graph)
+    {}
+
+    template <typename Weight>
+    std::optional<typename BidirectionalRouter<Weight>::RouteInfo> BidirectionalRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        Search forward(graph_.GetVertexCount());
+        Search backward(graph_.GetVertexCount());
+        forward.weights[from] = 0;
+        forward.queue.push({ 0, from });
+        backward.weights[to] = 0;
+        backward.queue.push({ 0, to });
+
+        std::optional<Weight> best_weight;
+        VertexId meeting = from;
+        const auto meet = [&](VertexId vertex) {
+            if (forward.weights[vertex] && backward.weights[vertex]) {
+                const Weight weight = *forward.weights[vertex] + *backward.weights[vertex];
+                if (!best_weight || weight < *best_weight) {
+                    best_weight = weight;
+                    meeting = vertex;
+                }
+            }
+        };
+        meet(from);
+
+        while (!forward.queue.empty() || !backward.queue.empty()) {
+            // an exhausted side is settled and adds nothing to the bound
+            const Weight forward_top = forward.queue.empty() ? 0 : forward.queue.top().first;
+            const Weight backward_top = backward.queue.empty() ? 0 : backward.queue.top().first;
+            if (best_weight && forward_top + backward_top >= *best_weight) {
+                break;
+            }
+
+            const bool is_forward = backward.queue.empty()
+                || (!forward.queue.empty() && forward_top <= backward_top);
+            auto& search = is_forward ? forward : backward;
+            const auto [weight, vertex] = search.queue.top();
+            search.queue.pop();
+            if (weight > *search.weights[vertex]) {
+                continue;
+            }
+
+            const auto relax = [&](EdgeId edge_id, VertexId next) {
+                const Weight next_weight = weight + graph_.GetEdge(edge_id).weight;
+                if (!search.weights[next] || next_weight < *search.weights[next]) {
+                    search.weights[next] = next_weight;
+                    search.edges[next] = edge_id;
+                    search.queue.push({ next_weight, next });
+                    meet(next);
+                }
+            };
+            if (is_forward) {
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                    relax(edge_id, graph_.GetEdge(edge_id).to);
+                }
+            }
+            else {
+                for (const EdgeId edge_id : reverse_incidence_.GetIncomingEdges(vertex)) {
+                    relax(edge_id, graph_.GetEdge(edge_id).from);
+                }
+            }
+        }
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = meeting; vertex != from; vertex = graph_.GetEdge(edges.back()).from) {
+            edges.push_back(forward.edges[vertex]);
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (VertexId vertex = meeting; vertex != to; vertex = graph_.GetEdge(edges.back()).to) {
+            edges.push_back(backward.edges[vertex]);
+        }
+        return this->SaveRoute(*best_weight, std::move(edges));
+    }
+
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "requests.h"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Binary form of base_requests. The file is a Header followed by the names
+// blob and the Stops, Distances, Buses and RouteStops arrays exactly as they
+// are laid out in memory (native byte order), so loading is a few reads.
+namespace BinaryNetwork {
+	const char MAGIC[8] = { 'B', 'M', 'N', 'E', 'T', 0, 0, 0 };
+	const uint32_t VERSION = 1;
+
+	struct Header {
+		char Magic[8];
+		uint32_t Version;
+		uint32_t NamesSize;
+		uint32_t StopCount;
+		uint32_t DistanceCount;
+		uint32_t BusCount;
+		uint32_t RouteStopCount;
+	};
+
+	struct NameRef {
+		uint32_t Offset;
+		uint32_t Length;
+	};
+
+	struct StopRecord {
+		NameRef Name;
+		double Latitude;
+		double Longitude;
+	};
+
+	struct DistanceRecord {
+		uint32_t From;
+		uint32_t To;
+		double Meters;
+	};
+
+	struct BusRecord {
+		NameRef Name;
+		// range of RouteStops, the way back of a non-roundtrip route included
+		uint32_t FirstStop;
+		uint32_t StopCount;
+	};
+
+	struct Network {
+		vector<char> Names;
+		vector<StopRecord> Stops;
+		vector<DistanceRecord> Distances;
+		vector<BusRecord> Buses;
+		vector<uint32_t> RouteStops;
+
+		string_view GetName(NameRef name) const {
+			return { Names.data() + name.Offset, name.Length };
+		}
+
+		NameRef AddName(string_view name) {
+			NameRef ref{ static_cast<uint32_t>(Names.size()), static_cast<uint32_t>(name.size()) };
+			Names.insert(Names.end(), name.begin(), name.end());
+			return ref;
+		}
+	};
+
+	inline Network BuildNetwork(const RequestBatch& requests) {
+		Network network;
+		unordered_map<string_view, uint32_t> stop_id_by_name;
+		for (const auto& request : requests.AddStops) {
+			stop_id_by_name[request.GetName()] = static_cast<uint32_t>(network.Stops.size());
+			network.Stops.push_back({ network.AddName(request.GetName()),
+				request.GetLocation().Latitude, request.GetLocation().Longitude });
+		}
+
+		auto get_stop_id = [&stop_id_by_name](const string& name) {
+			auto it = stop_id_by_name.find(name);
+			if (it == stop_id_by_name.end()) {
+				throw runtime_error("unknown stop " + name);
+			}
+			return it->second;
+		};
+
+		for (const auto& request : requests.AddStops) {
+			const uint32_t from = get_stop_id(request.GetName());
+			for (const auto& [stop_name, dist] : request.GetDistances()) {
+				network.Distances.push_back({ from, get_stop_id(stop_name), dist });
+			}
+		}
+		for (const auto& request : requests.AddBuses) {
+			network.Buses.push_back({ network.AddName(request.GetName()),
+				static_cast<uint32_t>(network.RouteStops.size()),
+				static_cast<uint32_t>(request.GetStops().size()) });
+			for (const auto& stop_name : request.GetStops()) {
+				network.RouteStops.push_back(get_stop_id(stop_name));
+			}
+		}
+		return network;
+	}
+
+	// Appends the stops and buses of the network to requests
+	inline void MakeRequests(const Network& network, RequestBatch& requests) {
+		vector<unordered_map<string, double>> distances(network.Stops.size());
+		for (const auto& record : network.Distances) {
+			distances[record.From][string(network.GetName(network.Stops[record.To].Name))] = record.Meters;
+		}
+
+		requests.AddStops.reserve(requests.AddStops.size() + network.Stops.size());
+		for (size_t i = 0; i < network.Stops.size(); ++i) {
+			const auto& stop = network.Stops[i];
+			requests.AddStops.emplace_back(string(network.GetName(stop.Name)),
+				Location{ stop.Latitude, stop.Longitude }, move(distances[i]));
+		}
+		requests.AddBuses.reserve(requests.AddBuses.size() + network.Buses.size());
+		for (const auto& bus : network.Buses) {
+			vector<string> stops;
+			stops.reserve(bus.StopCount);
+			for (uint32_t i = bus.FirstStop; i < bus.FirstStop + bus.StopCount; ++i) {
+				stops.emplace_back(network.GetName(network.Stops[network.RouteStops[i]].Name));
+			}
+			requests.AddBuses.emplace_back(string(network.GetName(bus.Name)), move(stops));
+		}
+	}
+
+	template <typename T>
+	void WriteArray(ostream& output, const vector<T>& data) {
+		output.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+	}
+
+	template <typename T>
+	void ReadArray(istream& input, vector<T>& data, size_t count) {
+		data.resize(count);
+		if (!input.read(reinterpret_cast<char*>(data.data()), count * sizeof(T))) {
+			throw runtime_error("binary network is truncated");
+		}
+	}
+
+	inline void Save(const Network& network, ostream& output) {
+		Header header;
+		memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+		header.Version = VERSION;
+		header.NamesSize = static_cast<uint32_t>(network.Names.size());
+		header.StopCount = static_cast<uint32_t>(network.Stops.size());
+		header.DistanceCount = static_cast<uint32_t>(network.Distances.size());
+		header.BusCount = static_cast<uint32_t>(network.Buses.size());
+		header.RouteStopCount = static_cast<uint32_t>(network.RouteStops.size());
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		WriteArray(output, network.Names);
+		WriteArray(output, network.Stops);
+		WriteArray(output, network.Distances);
+		WriteArray(output, network.Buses);
+		WriteArray(output, network.RouteStops);
+	}
+
+	// Every offset and index of a loaded network must point inside its arrays,
+	// otherwise a damaged file would be read out of bounds
+	inline void Validate(const Network& network) {
+		const auto check = [](bool condition) {
+			if (!condition) {
+				throw runtime_error("binary network is corrupted");
+			}
+		};
+		const auto check_name = [&](NameRef name) {
+			check(name.Offset <= network.Names.size() && name.Length <= network.Names.size() - name.Offset);
+		};
+		for (const auto& stop : network.Stops) {
+			check_name(stop.Name);
+		}
+		for (const auto& record : network.Distances) {
+			check(record.From < network.Stops.size() && record.To < network.Stops.size());
+		}
+		for (const auto& bus : network.Buses) {
+			check_name(bus.Name);
+			check(bus.FirstStop <= network.RouteStops.size()
+				&& bus.StopCount <= network.RouteStops.size() - bus.FirstStop);
+		}
+		for (const uint32_t stop_id : network.RouteStops) {
+			check(stop_id < network.Stops.size());
+		}
+	}
+
+	inline Network Load(istream& input) {
+		Header header;
+		if (!input.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+			memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != VERSION) {
+			throw runtime_error("not a binary network file");
+		}
+		Network network;
+		ReadArray(input, network.Names, header.NamesSize);
+		ReadArray(input, network.Stops, header.StopCount);
+		ReadArray(input, network.Distances, header.DistanceCount);
+		ReadArray(input, network.Buses, header.BusCount);
+		ReadArray(input, network.RouteStops, header.RouteStopCount);
+		Validate(network);
+		return network;
+	}
+}
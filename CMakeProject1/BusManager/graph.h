@@ -83,4 +83,46 @@ namespace Graph {
         const auto& edges = incidence_lists_[vertex];
         return { std::begin(edges), std::end(edges) };
     }
+
+
+    // Incoming edges of every vertex, for the searches running backwards.
+    // The edge ids of all vertices are stored in one array.
+    template <typename Weight>
+    class ReverseIncidenceLists {
+    private:
+        using IncomingEdgesRange = Range<std::vector<EdgeId>::const_iterator>;
+
+    public:
+        explicit ReverseIncidenceLists(const DirectedWeightedGraph<Weight>& graph);
+
+        IncomingEdgesRange GetIncomingEdges(VertexId vertex) const;
+
+    private:
+        std::vector<size_t> offsets_;
+        std::vector<EdgeId> edges_;
+    };
+
+
+    template <typename Weight>
+    ReverseIncidenceLists<Weight>::ReverseIncidenceLists(const DirectedWeightedGraph<Weight>& graph)
+        : offsets_(graph.GetVertexCount() + 1)
+        , edges_(graph.GetEdgeCount())
+    {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            ++offsets_[graph.GetEdge(edge_id).to + 1];
+        }
+        for (size_t vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+            offsets_[vertex + 1] += offsets_[vertex];
+        }
+        std::vector<size_t> positions(offsets_.begin(), offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            edges_[positions[graph.GetEdge(edge_id).to]++] = edge_id;
+        }
+    }
+
+    template <typename Weight>
+    typename ReverseIncidenceLists<Weight>::IncomingEdgesRange
+        ReverseIncidenceLists<Weight>::GetIncomingEdges(VertexId vertex) const {
+        return { edges_.begin() + offsets_[vertex], edges_.begin() + offsets_[vertex + 1] };
+    }
 }
@@ -0,0 +1,405 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+    // 2-hop labeling: every vertex keeps the distances to and from a few hubs,
+    // so a route weight is the best common hub of two sorted label lists.
+    // Labels are built by pruned Dijkstra searches in order of vertex degree.
+    // Every label entry keeps the edge to the next vertex towards its hub,
+    // which is enough to unpack the route.
+    template <typename Weight>
+    class HubLabelRouter : public IRouter<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        explicit HubLabelRouter(const Graph& graph);
+        // reads an index written by Save for the same graph
+        HubLabelRouter(const Graph& graph, std::istream& input);
+
+        using typename IRouter<Weight>::RouteInfo;
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+        void Save(std::ostream& output) const;
+
+        size_t GetLabelEntryCount() const {
+            return out_labels_.entries.size() + in_labels_.entries.size();
+        }
+
+    private:
+        static constexpr char MAGIC[8] = { 'B', 'M', 'H', 'U', 'B', 0, 0, 0 };
+        static constexpr uint32_t VERSION = 2;
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t vertex_count;
+            uint64_t edge_count;
+            // FNV-1a of every edge's from, to and weight, in edge order
+            uint64_t graph_checksum;
+            uint32_t weight_size;
+            uint32_t reserved;
+            uint64_t out_entry_count;
+            uint64_t in_entry_count;
+        };
+
+        // size of a label entry in the file, which has no padding
+        static constexpr size_t ENTRY_FILE_SIZE = sizeof(uint32_t) + sizeof(Weight) + sizeof(EdgeId);
+
+        struct LabelEntry {
+            uint32_t hub_rank;
+            Weight weight;
+            // out labels: the first edge from the vertex towards the hub,
+            // in labels: the last edge from the hub to the vertex
+            EdgeId edge;
+        };
+
+        // flat label lists of all vertices, sorted by hub rank
+        struct Labels {
+            std::vector<uint32_t> offsets;
+            std::vector<LabelEntry> entries;
+
+            const LabelEntry* begin(VertexId vertex) const {
+                return entries.data() + offsets[vertex];
+            }
+            const LabelEntry* end(VertexId vertex) const {
+                return entries.data() + offsets[vertex + 1];
+            }
+            const LabelEntry& Find(VertexId vertex, uint32_t hub_rank) const {
+                return *std::lower_bound(begin(vertex), end(vertex), hub_rank,
+                    [](const LabelEntry& entry, uint32_t rank) { return entry.hub_rank < rank; });
+            }
+        };
+
+        using LabelLists = std::vector<std::vector<LabelEntry>>;
+
+        struct Meeting {
+            Weight weight;
+            uint32_t hub_rank;
+        };
+
+        template <typename OutRange, typename InRange>
+        static std::optional<Meeting> FindMeeting(const OutRange& out, const InRange& in);
+
+        void BuildLabels();
+        void PrunedSearch(VertexId hub, uint32_t hub_rank, bool forward,
+            const ReverseIncidenceLists<Weight>& reverse_incidence,
+            LabelLists& out_labels, LabelLists& in_labels);
+        static Labels Flatten(LabelLists&& lists);
+
+        static uint64_t ComputeChecksum(const Graph& graph);
+        static void WriteEntries(std::ostream& output, const std::vector<LabelEntry>& entries);
+        static void ReadEntries(std::istream& input, std::vector<LabelEntry>& entries, size_t count);
+        void Validate(const Labels& labels) const;
+
+        const Graph& graph_;
+        std::vector<VertexId> vertex_by_rank_;
+        Labels out_labels_;
+        Labels in_labels_;
+    };
+
+
+    template <typename Weight>
+    HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph)
+        : graph_(graph)
+    {
+        BuildLabels();
+    }
+
+    template <typename Weight>
+    template <typename OutRange, typename InRange>
+    std::optional<typename HubLabelRouter<Weight>::Meeting>
+        HubLabelRouter<Weight>::FindMeeting(const OutRange& out, const InRange& in) {
+        std::optional<Meeting> best;
+        auto out_it = out.first;
+        auto in_it = in.first;
+        while (out_it != out.second && in_it != in.second) {
+            if (out_it->hub_rank < in_it->hub_rank) {
+                ++out_it;
+            }
+            else if (in_it->hub_rank < out_it->hub_rank) {
+                ++in_it;
+            }
+            else {
+                const Weight weight = out_it->weight + in_it->weight;
+                if (!best || weight < best->weight) {
+                    best = Meeting{ weight, out_it->hub_rank };
+                }
+                ++out_it;
+                ++in_it;
+            }
+        }
+        return best;
+    }
+
+    template <typename Weight>
+    void HubLabelRouter<Weight>::BuildLabels() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        const ReverseIncidenceLists<Weight> reverse_incidence(graph_);
+        std::vector<size_t> degree(vertex_count);
+        for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            ++degree[edge.from];
+            ++degree[edge.to];
+        }
+
+        vertex_by_rank_.resize(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            vertex_by_rank_[vertex] = vertex;
+        }
+        std::stable_sort(vertex_by_rank_.begin(), vertex_by_rank_.end(),
+            [&degree](VertexId lhs, VertexId rhs) { return degree[lhs] > degree[rhs]; });
+
+        LabelLists out_labels(vertex_count);
+        LabelLists in_labels(vertex_count);
+        for (uint32_t rank = 0; rank < vertex_count; ++rank) {
+            PrunedSearch(vertex_by_rank_[rank], rank, true, reverse_incidence, out_labels, in_labels);
+            PrunedSearch(vertex_by_rank_[rank], rank, false, reverse_incidence, out_labels, in_labels);
+        }
+        out_labels_ = Flatten(std::move(out_labels));
+        in_labels_ = Flatten(std::move(in_labels));
+    }
+
+    template <typename Weight>
+    void HubLabelRouter<Weight>::PrunedSearch(VertexId hub, uint32_t hub_rank, bool forward,
+        const ReverseIncidenceLists<Weight>& reverse_incidence,
+        LabelLists& out_labels, LabelLists& in_labels) {
+        // the forward search labels the vertices reachable from the hub,
+        // the backward one labels the vertices the hub is reachable from
+        auto& hub_labels = forward ? out_labels[hub] : in_labels[hub];
+        auto& reached_labels = forward ? in_labels : out_labels;
+
+        std::vector<std::optional<Weight>> weights(graph_.GetVertexCount());
+        std::vector<EdgeId> edges(graph_.GetVertexCount(), NO_EDGE);
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        weights[hub] = 0;
+        queue.push({ 0, hub });
+
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > *weights[vertex]) {
+                continue;
+            }
+
+            // prune the vertices already covered by more important hubs
+            const auto& labels = reached_labels[vertex];
+            const auto known = forward
+                ? FindMeeting(std::pair(hub_labels.cbegin(), hub_labels.cend()), std::pair(labels.cbegin(), labels.cend()))
+                : FindMeeting(std::pair(labels.cbegin(), labels.cend()), std::pair(hub_labels.cbegin(), hub_labels.cend()));
+            if (vertex != hub && known && known->weight <= weight) {
+                continue;
+            }
+            reached_labels[vertex].push_back({ hub_rank, weight, edges[vertex] });
+
+            const auto relax = [&](EdgeId edge_id, VertexId next) {
+                const Weight next_weight = weight + graph_.GetEdge(edge_id).weight;
+                if (!weights[next] || next_weight < *weights[next]) {
+                    weights[next] = next_weight;
+                    edges[next] = edge_id;
+                    queue.push({ next_weight, next });
+                }
+            };
+            if (forward) {
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                    relax(edge_id, graph_.GetEdge(edge_id).to);
+                }
+            }
+            else {
+                for (const EdgeId edge_id : reverse_incidence.GetIncomingEdges(vertex)) {
+                    relax(edge_id, graph_.GetEdge(edge_id).from);
+                }
+            }
+        }
+    }
+
+    template <typename Weight>
+    typename HubLabelRouter<Weight>::Labels HubLabelRouter<Weight>::Flatten(LabelLists&& lists) {
+        Labels labels;
+        labels.offsets.reserve(lists.size() + 1);
+        labels.offsets.push_back(0);
+        for (auto& list : lists) {
+            labels.entries.insert(labels.entries.end(), list.begin(), list.end());
+            labels.offsets.push_back(static_cast<uint32_t>(labels.entries.size()));
+            std::vector<LabelEntry>().swap(list);
+        }
+        return labels;
+    }
+
+    template <typename Weight>
+    std::optional<typename HubLabelRouter<Weight>::RouteInfo> HubLabelRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const auto meeting = FindMeeting(
+            std::pair(out_labels_.begin(from), out_labels_.end(from)),
+            std::pair(in_labels_.begin(to), in_labels_.end(to)));
+        if (!meeting) {
+            return std::nullopt;
+        }
+
+        const VertexId hub = vertex_by_rank_[meeting->hub_rank];
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = from; vertex != hub; ) {
+            const EdgeId edge_id = out_labels_.Find(vertex, meeting->hub_rank).edge;
+            edges.push_back(edge_id);
+            vertex = graph_.GetEdge(edge_id).to;
+        }
+        const size_t to_hub_count = edges.size();
+        for (VertexId vertex = to; vertex != hub; ) {
+            const EdgeId edge_id = in_labels_.Find(vertex, meeting->hub_rank).edge;
+            edges.push_back(edge_id);
+            vertex = graph_.GetEdge(edge_id).from;
+        }
+        std::reverse(edges.begin() + to_hub_count, edges.end());
+        return this->SaveRoute(meeting->weight, std::move(edges));
+    }
+
+    template <typename Weight>
+    void HubLabelRouter<Weight>::Save(std::ostream& output) const {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.vertex_count = static_cast<uint32_t>(graph_.GetVertexCount());
+        header.edge_count = graph_.GetEdgeCount();
+        header.graph_checksum = ComputeChecksum(graph_);
+        header.weight_size = sizeof(Weight);
+        header.out_entry_count = out_labels_.entries.size();
+        header.in_entry_count = in_labels_.entries.size();
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const auto write = [&output](const auto& data) {
+            output.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(data[0]));
+        };
+        write(vertex_by_rank_);
+        write(out_labels_.offsets);
+        WriteEntries(output, out_labels_.entries);
+        write(in_labels_.offsets);
+        WriteEntries(output, in_labels_.entries);
+    }
+
+    template <typename Weight>
+    HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph, std::istream& input)
+        : graph_(graph)
+    {
+        Header header;
+        if (!input.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            throw std::runtime_error("not a hub label index");
+        }
+        if (header.weight_size != sizeof(Weight)) {
+            throw std::runtime_error("hub label index has another weight type");
+        }
+        if (header.vertex_count != graph.GetVertexCount() || header.edge_count != graph.GetEdgeCount()
+            || header.graph_checksum != ComputeChecksum(graph)) {
+            throw std::runtime_error("hub label index was built for another graph");
+        }
+
+        const auto read = [&input](auto& data, size_t count) {
+            data.resize(count);
+            if (!input.read(reinterpret_cast<char*>(data.data()), count * sizeof(data[0]))) {
+                throw std::runtime_error("hub label index is truncated");
+            }
+        };
+        read(vertex_by_rank_, header.vertex_count);
+        read(out_labels_.offsets, header.vertex_count + 1);
+        ReadEntries(input, out_labels_.entries, header.out_entry_count);
+        read(in_labels_.offsets, header.vertex_count + 1);
+        ReadEntries(input, in_labels_.entries, header.in_entry_count);
+
+        std::vector<char> ranked(header.vertex_count);
+        for (const VertexId vertex : vertex_by_rank_) {
+            if (vertex >= header.vertex_count || ranked[vertex]) {
+                throw std::runtime_error("hub label index is corrupted");
+            }
+            ranked[vertex] = 1;
+        }
+        Validate(out_labels_);
+        Validate(in_labels_);
+    }
+
+    template <typename Weight>
+    uint64_t HubLabelRouter<Weight>::ComputeChecksum(const Graph& graph) {
+        uint64_t checksum = 14695981039346656037ull;
+        const auto add = [&checksum](const auto& value) {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+            for (size_t i = 0; i < sizeof(value); ++i) {
+                checksum = (checksum ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            add(static_cast<uint64_t>(edge.from));
+            add(static_cast<uint64_t>(edge.to));
+            add(edge.weight);
+        }
+        return checksum;
+    }
+
+    template <typename Weight>
+    void HubLabelRouter<Weight>::WriteEntries(std::ostream& output, const std::vector<LabelEntry>& entries) {
+        std::vector<char> buffer(entries.size() * ENTRY_FILE_SIZE);
+        char* data = buffer.data();
+        for (const auto& entry : entries) {
+            std::memcpy(data, &entry.hub_rank, sizeof(entry.hub_rank));
+            std::memcpy(data + sizeof(entry.hub_rank), &entry.weight, sizeof(entry.weight));
+            std::memcpy(data + sizeof(entry.hub_rank) + sizeof(entry.weight), &entry.edge, sizeof(entry.edge));
+            data += ENTRY_FILE_SIZE;
+        }
+        output.write(buffer.data(), buffer.size());
+    }
+
+    template <typename Weight>
+    void HubLabelRouter<Weight>::ReadEntries(std::istream& input, std::vector<LabelEntry>& entries, size_t count) {
+        std::vector<char> buffer(count * ENTRY_FILE_SIZE);
+        if (!input.read(buffer.data(), buffer.size())) {
+            throw std::runtime_error("hub label index is truncated");
+        }
+        entries.resize(count);
+        const char* data = buffer.data();
+        for (auto& entry : entries) {
+            std::memcpy(&entry.hub_rank, data, sizeof(entry.hub_rank));
+            std::memcpy(&entry.weight, data + sizeof(entry.hub_rank), sizeof(entry.weight));
+            std::memcpy(&entry.edge, data + sizeof(entry.hub_rank) + sizeof(entry.weight), sizeof(entry.edge));
+            data += ENTRY_FILE_SIZE;
+        }
+    }
+
+    // offsets must split the entries into per-vertex lists sorted by hub rank
+    // with valid ranks and edges, otherwise queries would read out of bounds
+    template <typename Weight>
+    void HubLabelRouter<Weight>::Validate(const Labels& labels) const {
+        const auto check = [](bool condition) {
+            if (!condition) {
+                throw std::runtime_error("hub label index is corrupted");
+            }
+        };
+        check(labels.offsets.front() == 0 && labels.offsets.back() == labels.entries.size());
+        for (size_t vertex = 0; vertex + 1 < labels.offsets.size(); ++vertex) {
+            check(labels.offsets[vertex] <= labels.offsets[vertex + 1]);
+            for (uint32_t i = labels.offsets[vertex]; i < labels.offsets[vertex + 1]; ++i) {
+                const LabelEntry& entry = labels.entries[i];
+                check(entry.hub_rank < vertex_by_rank_.size());
+                check(entry.edge < graph_.GetEdgeCount() || entry.edge == NO_EDGE);
+                check(i == labels.offsets[vertex] || labels.entries[i - 1].hub_rank < entry.hub_rank);
+            }
+        }
+    }
+
+}
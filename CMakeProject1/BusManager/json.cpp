@@ -1,7 +1,13 @@
 #include "json.h"
+#include <algorithm>
 #include <cassert>
-#include <iomanip>
+#include <charconv>
+#include <cstring>
 #include <cmath>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 
 using namespace std;
 
@@ -119,41 +125,517 @@ namespace Json {
     }
 
     void Node::Print(ostream& os) const {
+        Printer printer(os);
+        Print(printer);
+    }
+
+    void Node::Print(Printer& printer) const {
         if (holds_alternative<double>(*this)) {
-            double value = get<double>(*this);
-            if (abs(static_cast<int>(value) - value) < 1e-8) {
-                os << static_cast<int>(round(value));
-            }
-            else {
-                os << fixed << setprecision(6) << get<double>(*this);
-            }
+            printer.WriteNumber(get<double>(*this));
         }
         else if (holds_alternative<string>(*this)) {
-            os << "\"" << get<string>(*this) << "\"";
+            printer.WriteString(get<string>(*this));
         }
         else if (holds_alternative<vector<Node>>(*this)) {
-            os << "[\n";
-            for (size_t i = 0; i < (*this).AsArray().size(); ++i) {
-                (*this).AsArray()[i].Print(os);
-                if (i + 1 < (*this).AsArray().size()) {
-                    os << ",";
+            const auto& items = get<vector<Node>>(*this);
+            printer.Write('[');
+            printer.NewLine();
+            for (size_t i = 0; i < items.size(); ++i) {
+                items[i].Print(printer);
+                if (i + 1 < items.size()) {
+                    printer.Write(',');
                 }
-                os << "\n";
+                printer.NewLine();
             }
-            os << "]";
+            printer.Write(']');
         }
         else if (holds_alternative<map<string, Node>>(*this)) {
-            os << "{\n";
-            const auto& cur_map = (*this).AsMap();
+            const auto& cur_map = get<map<string, Node>>(*this);
+            printer.Write('{');
+            printer.NewLine();
             for (auto it = cur_map.cbegin(); it != cur_map.cend(); ++it) {
-                os << "\"" << it->first << "\": ";
-                (it->second).Print(os);
+                printer.WriteKey(it->first);
+                (it->second).Print(printer);
                 if (next(it) != cur_map.cend()) {
-                    os << ",";
+                    printer.Write(',');
+                }
+                printer.NewLine();
+            }
+            printer.Write('}');
+        }
+    }
+
+    pair<string, string> PrintWithHole(const map<string, Node>& object,
+        string_view hole_key, const PrintOptions& options) {
+        ostringstream stream;
+        string before_hole;
+        {
+            Printer printer(stream, options);
+            printer.Write('{');
+            printer.NewLine();
+            auto it = object.lower_bound(string(hole_key));
+            for (auto cur = object.cbegin(); cur != it; ++cur) {
+                printer.WriteKey(cur->first);
+                cur->second.Print(printer);
+                printer.Write(',');
+                printer.NewLine();
+            }
+            printer.WriteKey(hole_key);
+            printer.Flush();
+            before_hole = stream.str();
+            stream.str({});
+
+            for (; it != object.cend(); ++it) {
+                printer.Write(',');
+                printer.NewLine();
+                printer.WriteKey(it->first);
+                it->second.Print(printer);
+            }
+            printer.NewLine();
+            printer.Write('}');
+        }
+        return { move(before_hole), stream.str() };
+    }
+
+    Printer::Printer(ostream& os, PrintOptions options, size_t buffer_size)
+        : os(os)
+        , options(options)
+        , buffer(max<size_t>(buffer_size, 64))
+    {}
+
+    Printer::~Printer() {
+        Flush();
+    }
+
+    void Printer::Print(const Node& node) {
+        node.Print(*this);
+    }
+
+    void Printer::Flush() {
+        os.write(buffer.data(), used);
+        used = 0;
+    }
+
+    char* Printer::Reserve(size_t size) {
+        if (used + size > buffer.size()) {
+            Flush();
+            if (size > buffer.size()) {
+                buffer.resize(size);
+            }
+        }
+        return buffer.data() + used;
+    }
+
+    void Printer::Write(string_view text) {
+        memcpy(Reserve(text.size()), text.data(), text.size());
+        used += text.size();
+    }
+
+    void Printer::Write(char c) {
+        *Reserve(1) = c;
+        ++used;
+    }
+
+    void Printer::WriteNumber(double value) {
+        // enough for any int and for the shortest form of any double;
+        // fixed form of huge numbers falls back to a larger reservation
+        static const size_t MAX_NUMBER_LENGTH = 32;
+        char* first = Reserve(MAX_NUMBER_LENGTH);
+        char* last = buffer.data() + buffer.size();
+        to_chars_result result;
+        if (options.NumberFormat == PrintOptions::ENumberFormat::SHORTEST) {
+            result = to_chars(first, last, value);
+        }
+        else if (abs(static_cast<int>(value) - value) < 1e-8) {
+            result = to_chars(first, last, static_cast<int>(round(value)));
+        }
+        else {
+            result = to_chars(first, last, value, chars_format::fixed, 6);
+            if (result.ec != errc()) {
+                first = Reserve(numeric_limits<double>::max_exponent10 + 16);
+                last = buffer.data() + buffer.size();
+                result = to_chars(first, last, value, chars_format::fixed, 6);
+            }
+        }
+        used = result.ptr - buffer.data();
+    }
+
+    void Printer::WriteString(string_view value) {
+        char* out = Reserve(value.size() + 2);
+        *out++ = '"';
+        memcpy(out, value.data(), value.size());
+        out[value.size()] = '"';
+        used += value.size() + 2;
+    }
+
+    void Printer::WriteKey(string_view key) {
+        WriteString(key);
+        Write(options.Compact ? ":" : ": ");
+    }
+
+    void Printer::NewLine() {
+        if (!options.Compact) {
+            Write('\n');
+        }
+    }
+}
+
+namespace Json {
+    Arena::Arena(size_t block_size) : block_size(block_size) {
+    }
+
+    void* Arena::Allocate(size_t size, size_t alignment) {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+        if (padding + size > left) {
+            size_t new_block_size = max(block_size, size + alignment);
+            blocks.push_back(make_unique<char[]>(new_block_size));
+            current = blocks.back().get();
+            left = new_block_size;
+            padding = (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+        }
+        char* result = current + padding;
+        current = result + size;
+        left -= padding + size;
+        return result;
+    }
+
+    void Arena::Adopt(Arena&& other) {
+        move(other.blocks.begin(), other.blocks.end(), back_inserter(blocks));
+        other.blocks.clear();
+        other.current = nullptr;
+        other.left = 0;
+    }
+
+    const ArenaNode& ArenaMap::at(string_view key) const {
+        const ArenaEntry* entry = Find(key);
+        if (!entry) {
+            throw out_of_range("Json: no key " + string(key));
+        }
+        return entry->value;
+    }
+
+    size_t ArenaMap::count(string_view key) const {
+        return Find(key) ? 1 : 0;
+    }
+
+    const ArenaEntry* ArenaMap::Find(string_view key) const {
+        auto it = lower_bound(begin(), end(), key, [](const ArenaEntry& entry, string_view key) {
+            return entry.key < key;
+        });
+        if (it == end() || it->key != key) {
+            return nullptr;
+        }
+        return it;
+    }
+
+    ArenaNode ArenaNode::MakeArray(const ArenaNode* items, size_t count) {
+        ArenaNode node;
+        node.type = EType::ARRAY;
+        node.size = static_cast<uint32_t>(count);
+        node.items = items;
+        return node;
+    }
+
+    ArenaNode ArenaNode::MakeMap(const ArenaEntry* entries, size_t count) {
+        ArenaNode node;
+        node.type = EType::MAP;
+        node.size = static_cast<uint32_t>(count);
+        node.entries = entries;
+        return node;
+    }
+
+    ArenaNode ArenaNode::MakeDouble(double value) {
+        ArenaNode node;
+        node.type = EType::DOUBLE;
+        node.number = value;
+        return node;
+    }
+
+    ArenaNode ArenaNode::MakeString(string_view value) {
+        ArenaNode node;
+        node.type = EType::STRING;
+        node.size = static_cast<uint32_t>(value.size());
+        node.chars = value.data();
+        return node;
+    }
+
+    Span<ArenaNode> ArenaNode::AsArray() const {
+        if (type != EType::ARRAY) {
+            throw bad_variant_access();
+        }
+        return { items, size };
+    }
+
+    ArenaMap ArenaNode::AsMap() const {
+        if (type != EType::MAP) {
+            throw bad_variant_access();
+        }
+        return { entries, size };
+    }
+
+    double ArenaNode::AsDouble() const {
+        if (type != EType::DOUBLE) {
+            throw bad_variant_access();
+        }
+        return number;
+    }
+
+    string_view ArenaNode::AsString() const {
+        if (type != EType::STRING) {
+            throw bad_variant_access();
+        }
+        return { chars, size };
+    }
+
+    ArenaBuilder::ArenaBuilder(Arena& arena) : arena(arena) {
+    }
+
+    ArenaNode ArenaBuilder::FinishArray(size_t first) {
+        size_t count = items_stack.size() - first;
+        ArenaNode* items = arena.AllocateArray<ArenaNode>(count);
+        uninitialized_copy(items_stack.begin() + first, items_stack.end(), items);
+        items_stack.resize(first);
+        return ArenaNode::MakeArray(items, count);
+    }
+
+    ArenaNode ArenaBuilder::FinishMap(size_t first) {
+        // stable sort keeps the first of duplicate keys in front, as map::emplace does
+        stable_sort(entries_stack.begin() + first, entries_stack.end(),
+            [](const ArenaEntry& lhs, const ArenaEntry& rhs) {
+                return lhs.key < rhs.key;
+            });
+        size_t count = entries_stack.size() - first;
+        ArenaEntry* entries = arena.AllocateArray<ArenaEntry>(count);
+        uninitialized_copy(entries_stack.begin() + first, entries_stack.end(), entries);
+        entries_stack.resize(first);
+        return ArenaNode::MakeMap(entries, count);
+    }
+
+    namespace {
+        // Same grammar as LoadNode, but reads from a contiguous buffer and
+        // stores the tree in an arena.
+        class ArenaParser {
+        public:
+            ArenaParser(string_view text, Arena& arena)
+                : pos(text.data())
+                , end(text.data() + text.size())
+                , builder(arena)
+            {}
+
+            ArenaNode ParseNode() {
+                char c = NextChar();
+                if (c == '[') {
+                    return ParseArray();
+                }
+                else if (c == '{') {
+                    return ParseMap();
+                }
+                else if (c == '"') {
+                    return ArenaNode::MakeString(ParseString());
+                }
+                else {
+                    --pos;
+                    return ParseDouble();
+                }
+            }
+
+        private:
+            char NextChar() {
+                while (pos != end && isspace(static_cast<unsigned char>(*pos))) {
+                    ++pos;
+                }
+                if (pos == end) {
+                    throw runtime_error("Json: unexpected end of input");
                 }
-                os << "\n";
+                return *pos++;
             }
-            os << "}";
+
+            ArenaNode ParseArray() {
+                size_t first = builder.ItemsBegin();
+                for (char c; (c = NextChar()) != ']'; ) {
+                    if (c != ',') {
+                        --pos;
+                    }
+                    builder.AddItem(ParseNode());
+                }
+                return builder.FinishArray(first);
+            }
+
+            ArenaNode ParseMap() {
+                size_t first = builder.EntriesBegin();
+                for (char c; (c = NextChar()) != '}'; ) {
+                    if (c == ',') {
+                        NextChar();
+                    }
+                    string_view key = ParseString();
+                    NextChar();
+                    builder.AddEntry(key, ParseNode());
+                }
+                return builder.FinishMap(first);
+            }
+
+            string_view ParseString() {
+                const char* quote = static_cast<const char*>(memchr(pos, '"', end - pos));
+                if (!quote) {
+                    throw runtime_error("Json: unterminated string");
+                }
+                string_view result(pos, quote - pos);
+                pos = quote + 1;
+                return result;
+            }
+
+            ArenaNode ParseDouble() {
+                auto [value, ptr] = ParseScalar(pos, end);
+                pos = ptr;
+                return ArenaNode::MakeDouble(value);
+            }
+
+            const char* pos;
+            const char* end;
+            ArenaBuilder builder;
+        };
+    }
+
+    pair<double, const char*> ParseScalar(const char* pos, const char* end) {
+        if (*pos == 't') {
+            assert(string_view(pos, min<size_t>(4, end - pos)) == "true");
+            return { 1.0, pos + 4 };
+        }
+        if (*pos == 'f') {
+            assert(string_view(pos, min<size_t>(5, end - pos)) == "false");
+            return { 0.0, pos + 5 };
         }
+
+        double result = 0;
+        auto [ptr, ec] = from_chars(pos, end, result);
+        if (ec != errc()) {
+            throw runtime_error("Json: bad number");
+        }
+        return { result, ptr };
+    }
+
+    ArenaNode ParseArena(string_view text, Arena& arena) {
+        return ArenaParser(text, arena).ParseNode();
+    }
+
+    ArenaDocument::ArenaDocument(vector<char> text, const ParseFunction& parse) : text(move(text)) {
+        root = parse({ this->text.data(), this->text.size() }, arena);
+    }
+
+    const ArenaNode& ArenaDocument::GetRoot() const {
+        return root;
+    }
+
+    vector<char> ReadAll(istream& input) {
+        vector<char> result;
+        char buffer[1 << 16];
+        while (input.read(buffer, sizeof(buffer)) || input.gcount()) {
+            result.insert(result.end(), buffer, buffer + input.gcount());
+        }
+        return result;
+    }
+
+    namespace {
+        const string_view SPACES = " \t\n\r";
+
+        size_t SkipSpaces(string_view text, size_t pos) {
+            pos = text.find_first_not_of(SPACES, pos);
+            if (pos == string_view::npos) {
+                throw runtime_error("Json: unexpected end of input");
+            }
+            return pos;
+        }
+
+        size_t SkipString(string_view text, size_t quote_pos) {
+            size_t pos = text.find('"', quote_pos + 1);
+            if (pos == string_view::npos) {
+                throw runtime_error("Json: unterminated string");
+            }
+            return pos + 1;
+        }
+    }
+
+    size_t SkipValue(string_view text) {
+        size_t pos = SkipSpaces(text, 0);
+        if (text[pos] == '"') {
+            return SkipString(text, pos);
+        }
+        if (text[pos] != '[' && text[pos] != '{') {
+            pos = text.find_first_of(",]}", pos);
+            pos = pos == string_view::npos ? text.size() : pos;
+            return text.find_last_not_of(SPACES, pos - 1) + 1;
+        }
+
+        size_t depth = 0;
+        do {
+            pos = text.find_first_of("\"[]{}", pos);
+            if (pos == string_view::npos) {
+                throw runtime_error("Json: unexpected end of input");
+            }
+            char c = text[pos];
+            if (c == '"') {
+                pos = SkipString(text, pos);
+                continue;
+            }
+            depth += (c == '[' || c == '{') ? 1 : -1;
+            ++pos;
+        } while (depth);
+        return pos;
+    }
+
+    vector<pair<string_view, string_view>> SplitObject(string_view text) {
+        vector<pair<string_view, string_view>> result;
+        size_t pos = SkipSpaces(text, 0);
+        if (text[pos] != '{') {
+            throw runtime_error("Json: expected object");
+        }
+        while (true) {
+            pos = SkipSpaces(text, pos + 1);
+            if (text[pos] == '}') {
+                break;
+            }
+            size_t key_end = SkipString(text, pos);
+            string_view key = text.substr(pos + 1, key_end - pos - 2);
+            pos = SkipSpaces(text, key_end);
+            if (text[pos] != ':') {
+                throw runtime_error("Json: expected ':'");
+            }
+            size_t value_begin = SkipSpaces(text, pos + 1);
+            size_t value_end = value_begin + SkipValue(text.substr(value_begin));
+            result.emplace_back(key, text.substr(value_begin, value_end - value_begin));
+            pos = SkipSpaces(text, value_end);
+            if (text[pos] == '}') {
+                break;
+            }
+        }
+        return result;
+    }
+
+    ArrayReader::ArrayReader(string_view text) {
+        size_t pos = SkipSpaces(text, 0);
+        if (text[pos] != '[') {
+            throw runtime_error("Json: expected array");
+        }
+        rest = text.substr(pos + 1);
+    }
+
+    string_view ArrayReader::Next() {
+        if (rest.empty()) {
+            return {};
+        }
+        size_t pos = SkipSpaces(rest, 0);
+        if (rest[pos] == ']') {
+            rest = {};
+            return {};
+        }
+        pos = SkipSpaces(rest, pos + (rest[pos] == ',' ? 1 : 0));
+        size_t length = SkipValue(rest.substr(pos));
+        auto value = rest.substr(pos, length);
+        rest.remove_prefix(pos + length);
+        return value;
+    }
+
+    ArenaDocument LoadArena(istream& input) {
+        return ArenaDocument(ReadAll(input));
     }
 }
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <istream>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <sstream>
 #include <variant>
 #include <vector>
 
 namespace Json {
+    class Printer;
+
     class Node : std::variant<std::vector<Node>,
         std::map<std::string, Node>,
         double,
@@ -33,6 +40,46 @@ namespace Json {
         }
         
         void Print(std::ostream& os) const;
+        void Print(Printer& printer) const;
+    };
+
+    struct PrintOptions {
+        enum class ENumberFormat {
+            FIXED,   // integers as is, other numbers with 6 digits after the point
+            SHORTEST // shortest representation that reads back to the same double
+        } NumberFormat = ENumberFormat::FIXED;
+
+        // no line breaks between elements and no space after ':'
+        bool Compact = false;
+    };
+
+    // Writes JSON into an internal buffer and passes it to the stream
+    // in large blocks. Whatever is left is flushed on destruction.
+    class Printer {
+    public:
+        explicit Printer(std::ostream& os, PrintOptions options = {}, size_t buffer_size = 1 << 16);
+        ~Printer();
+
+        Printer(const Printer&) = delete;
+        Printer& operator=(const Printer&) = delete;
+
+        void Print(const Node& node);
+        void Flush();
+
+        void Write(std::string_view text);
+        void Write(char c);
+        void WriteNumber(double value);
+        void WriteString(std::string_view value);
+        void WriteKey(std::string_view key);
+        void NewLine();
+
+    private:
+        char* Reserve(size_t size);
+
+        std::ostream& os;
+        PrintOptions options;
+        std::vector<char> buffer;
+        size_t used = 0;
     };
 
     class Document {
@@ -46,4 +93,177 @@ namespace Json {
     };
 
     Document Load(std::istream& input);
+
+    // Prints an object with hole_key added in its sorted place, but without
+    // its value: returns the text before the value and the text after it,
+    // so that the value can be written in between later
+    std::pair<std::string, std::string> PrintWithHole(const std::map<std::string, Node>& object,
+        std::string_view hole_key, const PrintOptions& options);
+
+    // Bump allocator: memory is handed out from large blocks and released
+    // all at once when the arena is destroyed.
+    class Arena {
+    public:
+        explicit Arena(size_t block_size = 1 << 16);
+
+        void* Allocate(size_t size, size_t alignment);
+
+        // Takes over the blocks of another arena, e.g. one filled by another thread
+        void Adopt(Arena&& other);
+
+        template <typename T>
+        T* AllocateArray(size_t count) {
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+    private:
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t block_size;
+        char* current = nullptr;
+        size_t left = 0;
+    };
+
+    template <typename T>
+    class Span {
+    public:
+        Span() = default;
+        Span(const T* data, size_t size) : data(data), count(size) {}
+
+        const T* begin() const { return data; }
+        const T* end() const { return data + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const T& operator[](size_t idx) const { return data[idx]; }
+
+    private:
+        const T* data = nullptr;
+        size_t count = 0;
+    };
+
+    class ArenaNode;
+    struct ArenaEntry;
+
+    class ArenaMap : public Span<ArenaEntry> {
+    public:
+        using Span::Span;
+
+        const ArenaNode& at(std::string_view key) const;
+        size_t count(std::string_view key) const;
+
+    private:
+        const ArenaEntry* Find(std::string_view key) const;
+    };
+
+    // Read-only node of an ArenaDocument. Children live in the document arena,
+    // object entries are sorted by key and strings point into the input text.
+    class ArenaNode {
+    public:
+        enum class EType : uint8_t {
+            ARRAY,
+            MAP,
+            DOUBLE,
+            STRING
+        };
+
+        static ArenaNode MakeArray(const ArenaNode* items, size_t count);
+        static ArenaNode MakeMap(const ArenaEntry* entries, size_t count);
+        static ArenaNode MakeDouble(double value);
+        static ArenaNode MakeString(std::string_view value);
+
+        EType Type() const {
+            return type;
+        }
+
+        Span<ArenaNode> AsArray() const;
+        ArenaMap AsMap() const;
+        double AsDouble() const;
+        std::string_view AsString() const;
+
+    private:
+        EType type = EType::DOUBLE;
+        uint32_t size = 0;
+        union {
+            double number = 0;
+            const char* chars;
+            const ArenaNode* items;
+            const ArenaEntry* entries;
+        };
+    };
+
+    struct ArenaEntry {
+        std::string_view key;
+        ArenaNode value;
+    };
+
+    // Collects children of the nodes being parsed on shared stacks and copies
+    // every finished array or object into the arena in one piece.
+    class ArenaBuilder {
+    public:
+        explicit ArenaBuilder(Arena& arena);
+
+        size_t ItemsBegin() const {
+            return items_stack.size();
+        }
+        void AddItem(const ArenaNode& node) {
+            items_stack.push_back(node);
+        }
+        ArenaNode FinishArray(size_t first);
+
+        size_t EntriesBegin() const {
+            return entries_stack.size();
+        }
+        void AddEntry(std::string_view key, const ArenaNode& node) {
+            entries_stack.push_back({ key, node });
+        }
+        ArenaNode FinishMap(size_t first);
+
+    private:
+        Arena& arena;
+        std::vector<ArenaNode> items_stack;
+        std::vector<ArenaEntry> entries_stack;
+    };
+
+    // Reads true, false or a number starting at pos; returns the value
+    // and the position right after it
+    std::pair<double, const char*> ParseScalar(const char* pos, const char* end);
+
+    // Parses the whole text into the arena, same grammar as Load
+    ArenaNode ParseArena(std::string_view text, Arena& arena);
+
+    class ArenaDocument {
+    public:
+        using ParseFunction = std::function<ArenaNode(std::string_view text, Arena& arena)>;
+
+        explicit ArenaDocument(std::vector<char> text, const ParseFunction& parse = ParseArena);
+
+        const ArenaNode& GetRoot() const;
+
+    private:
+        std::vector<char> text;
+        Arena arena;
+        ArenaNode root;
+    };
+
+    std::vector<char> ReadAll(std::istream& input);
+
+    // Length of the value at the beginning of text, leading spaces included.
+    // Only strings and brackets are looked at, nothing is parsed.
+    size_t SkipValue(std::string_view text);
+
+    // Members of an object as raw key and value texts
+    std::vector<std::pair<std::string_view, std::string_view>> SplitObject(std::string_view text);
+
+    // Hands out the elements of an array as raw texts one by one
+    class ArrayReader {
+    public:
+        explicit ArrayReader(std::string_view text);
+
+        // empty once the array is over
+        std::string_view Next();
+
+    private:
+        std::string_view rest;
+    };
+
+    ArenaDocument LoadArena(std::istream& input);
 }
@@ -0,0 +1,94 @@
+#include "json.h"
+#include "json_index.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace Json;
+
+// Input shaped like a BusManager request file
+string GenerateInput(size_t target_size) {
+	mt19937 gen(42);
+	uniform_real_distribution<double> coordinate(55.5, 55.8);
+	uniform_int_distribution<int> stop_id(0, 9999);
+	uniform_int_distribution<int> distance(100, 5000);
+
+	ostringstream out;
+	out << fixed << setprecision(6);
+	out << "{\n  \"routing_settings\": {\"bus_wait_time\": 6, \"bus_velocity\": 40},\n";
+	out << "  \"base_requests\": [\n";
+	for (int i = 0; static_cast<size_t>(out.tellp()) < target_size; ++i) {
+		if (i) {
+			out << ",\n";
+		}
+		if (i % 3) {
+			out << "    {\"type\": \"Stop\", \"name\": \"Stop " << i << "\", \"latitude\": " << coordinate(gen)
+				<< ", \"longitude\": " << coordinate(gen) << ", \"road_distances\": {\"Stop "
+				<< stop_id(gen) << "\": " << distance(gen) << ", \"Stop " << stop_id(gen) << "\": "
+				<< distance(gen) << "}}";
+		}
+		else {
+			out << "    {\"type\": \"Bus\", \"name\": \"" << i << "\", \"stops\": [";
+			for (int j = 0; j < 8; ++j) {
+				out << (j ? ", " : "") << "\"Stop " << stop_id(gen) << "\"";
+			}
+			out << "], \"is_roundtrip\": false}";
+		}
+	}
+	out << "\n  ],\n  \"stat_requests\": []\n}\n";
+	return out.str();
+}
+
+template <typename Func>
+void Measure(const string& name, size_t bytes, Func func) {
+	auto start = chrono::steady_clock::now();
+	func();
+	chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+	cout << setw(28) << left << name << fixed << setprecision(1)
+		<< bytes / seconds.count() / (1 << 20) << " MB/s\n";
+}
+
+int main(int argc, char* argv[]) {
+	size_t megabytes = argc > 1 ? stoul(argv[1]) : 64;
+	const string text = GenerateInput(megabytes << 20);
+	const vector<char> buffer(text.begin(), text.end());
+	cout << "input: " << text.size() / (1 << 20) << " MB\n";
+
+	size_t checksum = 0;
+	Measure("Load (istream)", text.size(), [&] {
+		istringstream input(text);
+		checksum += Load(input).GetRoot().AsMap().size();
+	});
+	Measure("ParseArena", text.size(), [&] {
+		Arena arena;
+		checksum += ParseArena(text, arena).AsMap().size();
+	});
+	Measure("index, scalar", text.size(), [&] {
+		checksum += BuildStructuralIndexScalar(text).size();
+	});
+	Measure("index", text.size(), [&] {
+		checksum += BuildStructuralIndex(text).size();
+	});
+	Measure("ParseIndexed", text.size(), [&] {
+		Arena arena;
+		checksum += ParseIndexed(text, arena).AsMap().size();
+	});
+	Measure("ArenaDocument indexed", text.size(), [&] {
+		ArenaDocument document(buffer, [](string_view text, Arena& arena) {
+			return ParseIndexed(text, arena);
+		});
+		checksum += document.GetRoot().AsMap().size();
+	});
+	for (size_t threads : {2, 4, 8}) {
+		Measure("ParseParallel, " + to_string(threads) + " threads", text.size(), [&] {
+			Arena arena;
+			checksum += ParseParallel(text, arena, threads).AsMap().size();
+		});
+	}
+	cerr << checksum << "\n";
+}
@@ -0,0 +1,357 @@
+#include "json_index.h"
+
+#include <bit>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_INDEX_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace Json {
+    namespace {
+        const size_t BLOCK_SIZE = 64;
+
+        struct BlockMasks {
+            uint64_t quotes = 0;
+            uint64_t operators = 0;
+            uint64_t spaces = 0;
+        };
+
+        bool IsOperator(char c) {
+            return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+        }
+
+        bool IsSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        BlockMasks ClassifyBlockScalar(const char* block) {
+            BlockMasks masks;
+            for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+                masks.quotes |= static_cast<uint64_t>(block[i] == '"') << i;
+                masks.operators |= static_cast<uint64_t>(IsOperator(block[i])) << i;
+                masks.spaces |= static_cast<uint64_t>(IsSpace(block[i])) << i;
+            }
+            return masks;
+        }
+
+#ifdef JSON_INDEX_SSE2
+        uint64_t EqualMask(const __m128i chunks[4], char c) {
+            const __m128i pattern = _mm_set1_epi8(c);
+            uint64_t mask = 0;
+            for (int i = 0; i < 4; ++i) {
+                uint64_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], pattern)));
+                mask |= bits << (16 * i);
+            }
+            return mask;
+        }
+
+        BlockMasks ClassifyBlock(const char* block) {
+            __m128i chunks[4];
+            for (int i = 0; i < 4; ++i) {
+                chunks[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+            }
+            BlockMasks masks;
+            masks.quotes = EqualMask(chunks, '"');
+            masks.operators = EqualMask(chunks, '{') | EqualMask(chunks, '}') |
+                EqualMask(chunks, '[') | EqualMask(chunks, ']') |
+                EqualMask(chunks, ':') | EqualMask(chunks, ',');
+            masks.spaces = EqualMask(chunks, ' ') | EqualMask(chunks, '\t') |
+                EqualMask(chunks, '\n') | EqualMask(chunks, '\r');
+            return masks;
+        }
+#else
+        BlockMasks ClassifyBlock(const char* block) {
+            return ClassifyBlockScalar(block);
+        }
+#endif
+
+        // bit i of the result is the xor of bits 0..i of mask
+        uint64_t PrefixXor(uint64_t mask) {
+            mask ^= mask << 1;
+            mask ^= mask << 2;
+            mask ^= mask << 4;
+            mask ^= mask << 8;
+            mask ^= mask << 16;
+            mask ^= mask << 32;
+            return mask;
+        }
+
+        template <typename Classify>
+        StructuralIndex BuildIndex(string_view text, Classify classify) {
+            if (text.size() > numeric_limits<uint32_t>::max()) {
+                throw length_error("Json: input is too large to index");
+            }
+
+            StructuralIndex index;
+            index.reserve(text.size() / 8);
+            // all ones while the previous block ended inside a string
+            uint64_t in_string_carry = 0;
+            // 1 if the previous block ended inside a number or literal
+            uint64_t scalar_carry = 0;
+
+            auto process_block = [&](const char* block, uint32_t offset) {
+                const BlockMasks masks = classify(block);
+                // opening quotes and string contents are set, closing quotes are not
+                const uint64_t in_string = PrefixXor(masks.quotes) ^ in_string_carry;
+                in_string_carry = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+                // numbers and literals are indexed by their first character
+                const uint64_t scalar = ~(masks.operators | masks.quotes | masks.spaces | in_string);
+                const uint64_t scalar_starts = scalar & ~((scalar << 1) | scalar_carry);
+                scalar_carry = scalar >> 63;
+
+                for (uint64_t structural = (masks.operators & ~in_string) | masks.quotes | scalar_starts;
+                    structural; structural &= structural - 1) {
+                    index.push_back(offset + static_cast<uint32_t>(countr_zero(structural)));
+                }
+            };
+
+            size_t offset = 0;
+            for (; offset + BLOCK_SIZE <= text.size(); offset += BLOCK_SIZE) {
+                process_block(text.data() + offset, static_cast<uint32_t>(offset));
+            }
+            if (offset < text.size()) {
+                char tail[BLOCK_SIZE];
+                memset(tail, ' ', BLOCK_SIZE);
+                memcpy(tail, text.data() + offset, text.size() - offset);
+                process_block(tail, static_cast<uint32_t>(offset));
+            }
+            return index;
+        }
+
+        class IndexedParser {
+        public:
+            IndexedParser(string_view text, Span<uint32_t> index, Arena& arena)
+                : text(text)
+                , index(index)
+                , arena(arena)
+                , builder(arena)
+            {}
+
+            // Arrays that are values of the root object are split between threads
+            ArenaNode ParseRoot(size_t thread_count) {
+                if (thread_count > 1 && Peek() == '{') {
+                    Consume();
+                    return ParseMap(thread_count);
+                }
+                return ParseValue();
+            }
+
+            // Parses comma separated values until the index is exhausted
+            void ParseValues(vector<ArenaNode>& values) {
+                values.push_back(ParseValue());
+                while (next < index.size()) {
+                    if (Consume() != ',') {
+                        throw runtime_error("Json: expected ','");
+                    }
+                    values.push_back(ParseValue());
+                }
+            }
+
+            ArenaNode ParseValue() {
+                char c = Consume();
+                if (c == '[') {
+                    return ParseArray();
+                }
+                else if (c == '{') {
+                    return ParseMap();
+                }
+                else if (c == '"') {
+                    return ArenaNode::MakeString(FinishString());
+                }
+                auto [value, ptr] = ParseScalar(text.data() + pos - 1, text.data() + text.size());
+                if (next < index.size() && ptr > text.data() + index[next]) {
+                    throw runtime_error("Json: bad number");
+                }
+                return ArenaNode::MakeDouble(value);
+            }
+
+        private:
+            char Peek() const {
+                return next < index.size() ? text[index[next]] : '\0';
+            }
+
+            char Consume() {
+                if (next == index.size()) {
+                    throw runtime_error("Json: unexpected end of input");
+                }
+                pos = index[next++] + 1;
+                return text[pos - 1];
+            }
+
+            bool ConsumeIfEmpty(char closing) {
+                if (next < index.size() && text[index[next]] == closing) {
+                    Consume();
+                    return true;
+                }
+                return false;
+            }
+
+            // the opening quote is already consumed, the next index entry is the closing one
+            string_view FinishString() {
+                size_t begin = pos;
+                if (Consume() != '"') {
+                    throw runtime_error("Json: unterminated string");
+                }
+                return text.substr(begin, pos - 1 - begin);
+            }
+
+            ArenaNode ParseArray() {
+                size_t first = builder.ItemsBegin();
+                if (!ConsumeIfEmpty(']')) {
+                    char c;
+                    do {
+                        builder.AddItem(ParseValue());
+                    } while ((c = Consume()) == ',');
+                    if (c != ']') {
+                        throw runtime_error("Json: expected ']'");
+                    }
+                }
+                return builder.FinishArray(first);
+            }
+
+            ArenaNode ParseMap(size_t thread_count = 1) {
+                size_t first = builder.EntriesBegin();
+                if (!ConsumeIfEmpty('}')) {
+                    char c;
+                    do {
+                        if (Consume() != '"') {
+                            throw runtime_error("Json: expected key");
+                        }
+                        string_view key = FinishString();
+                        if (Consume() != ':') {
+                            throw runtime_error("Json: expected ':'");
+                        }
+                        builder.AddEntry(key, thread_count > 1 && Peek() == '['
+                            ? ParseArrayParallel(thread_count)
+                            : ParseValue());
+                    } while ((c = Consume()) == ',');
+                    if (c != '}') {
+                        throw runtime_error("Json: expected '}'");
+                    }
+                }
+                return builder.FinishMap(first);
+            }
+
+            ArenaNode ParseArrayParallel(size_t thread_count) {
+                static const size_t MIN_ELEMENTS_PER_THREAD = 256;
+
+                Consume();
+                // index positions where elements start; commas and brackets
+                // inside strings are not indexed, so only depth is tracked
+                vector<size_t> starts;
+                size_t closing = next;
+                if (Peek() != ']') {
+                    starts.push_back(next);
+                }
+                for (size_t depth = 0; closing < index.size(); ++closing) {
+                    char c = text[index[closing]];
+                    if (c == '[' || c == '{') {
+                        ++depth;
+                    }
+                    else if (c == ']' || c == '}') {
+                        if (depth == 0) {
+                            break;
+                        }
+                        --depth;
+                    }
+                    else if (c == ',' && depth == 0) {
+                        starts.push_back(closing + 1);
+                    }
+                }
+                if (closing == index.size()) {
+                    throw runtime_error("Json: expected ']'");
+                }
+
+                thread_count = min(thread_count, starts.size() / MIN_ELEMENTS_PER_THREAD);
+                if (thread_count <= 1) {
+                    return ParseValueAt(next - 1);
+                }
+
+                struct Chunk {
+                    Arena arena;
+                    vector<ArenaNode> values;
+                };
+                auto parse_chunk = [this](size_t first, size_t last) {
+                    Chunk chunk;
+                    Span<uint32_t> chunk_index(index.begin() + first, last - first);
+                    IndexedParser(text, chunk_index, chunk.arena).ParseValues(chunk.values);
+                    return chunk;
+                };
+
+                vector<future<Chunk>> chunks;
+                for (size_t i = 0; i < thread_count; ++i) {
+                    size_t first = starts[starts.size() * i / thread_count];
+                    size_t last = i + 1 < thread_count
+                        ? starts[starts.size() * (i + 1) / thread_count] - 1
+                        : closing;
+                    chunks.push_back(async(launch::async, parse_chunk, first, last));
+                }
+
+                size_t first_item = builder.ItemsBegin();
+                for (auto& chunk_future : chunks) {
+                    Chunk chunk = chunk_future.get();
+                    for (const ArenaNode& value : chunk.values) {
+                        builder.AddItem(value);
+                    }
+                    arena.Adopt(move(chunk.arena));
+                }
+                next = closing;
+                Consume();
+                return builder.FinishArray(first_item);
+            }
+
+            ArenaNode ParseValueAt(size_t index_pos) {
+                next = index_pos;
+                return ParseValue();
+            }
+
+            string_view text;
+            Span<uint32_t> index;
+            Arena& arena;
+            size_t next = 0;
+            size_t pos = 0;
+            ArenaBuilder builder;
+        };
+    }
+
+    StructuralIndex BuildStructuralIndex(string_view text) {
+        return BuildIndex(text, ClassifyBlock);
+    }
+
+    StructuralIndex BuildStructuralIndexScalar(string_view text) {
+        return BuildIndex(text, ClassifyBlockScalar);
+    }
+
+    ArenaNode ParseIndexed(string_view text, const StructuralIndex& index, Arena& arena) {
+        return IndexedParser(text, { index.data(), index.size() }, arena).ParseValue();
+    }
+
+    ArenaNode ParseIndexed(string_view text, Arena& arena) {
+        return ParseIndexed(text, BuildStructuralIndex(text), arena);
+    }
+
+    ArenaDocument LoadIndexed(istream& input) {
+        return ArenaDocument(ReadAll(input), [](string_view text, Arena& arena) {
+            return ParseIndexed(text, arena);
+        });
+    }
+
+    ArenaNode ParseParallel(string_view text, Arena& arena, size_t thread_count) {
+        const StructuralIndex index = BuildStructuralIndex(text);
+        return IndexedParser(text, { index.data(), index.size() }, arena).ParseRoot(thread_count);
+    }
+
+    ArenaDocument LoadParallel(istream& input, size_t thread_count) {
+        return ArenaDocument(ReadAll(input), [thread_count](string_view text, Arena& arena) {
+            return ParseParallel(text, arena, thread_count);
+        });
+    }
+}
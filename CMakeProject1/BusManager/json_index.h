@@ -0,0 +1,32 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <istream>
+#include <string_view>
+#include <vector>
+
+// Two-stage parsing in the style of simdjson.
+// Stage one scans the text in 64-byte blocks and records the positions of all
+// quotes, of the brackets, colons and commas outside of strings and of the
+// first characters of numbers and literals.
+// Stage two walks this index and builds an ArenaNode tree without looking
+// at whitespace.
+namespace Json {
+    using StructuralIndex = std::vector<uint32_t>;
+
+    // Vectorized with SSE2 where available, otherwise same as the scalar version
+    StructuralIndex BuildStructuralIndex(std::string_view text);
+    StructuralIndex BuildStructuralIndexScalar(std::string_view text);
+
+    ArenaNode ParseIndexed(std::string_view text, const StructuralIndex& index, Arena& arena);
+    ArenaNode ParseIndexed(std::string_view text, Arena& arena);
+
+    ArenaDocument LoadIndexed(std::istream& input);
+
+    // Same as ParseIndexed, but arrays that are values of the root object
+    // are split at element boundaries and parsed on several threads
+    ArenaNode ParseParallel(std::string_view text, Arena& arena, size_t thread_count);
+    ArenaDocument LoadParallel(std::istream& input, size_t thread_count);
+}
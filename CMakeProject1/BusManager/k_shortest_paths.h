@@ -0,0 +1,193 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+    // Yen's k shortest loopless paths. One backward Dijkstra from the target
+    // gives the first path and the distances to the target, which are then
+    // used as A* potentials by every spur search of the query: removing edges
+    // and vertices only makes the distances longer, so they stay admissible.
+    template <typename Weight>
+    class KShortestPaths {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        explicit KShortestPaths(const Graph& graph);
+
+        struct Path {
+            Weight weight;
+            std::vector<EdgeId> edges;
+        };
+
+        // at most k paths without repeated vertices, shortest first
+        std::vector<Path> FindPaths(VertexId from, VertexId to, size_t k) const;
+
+    private:
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+        struct TargetTree {
+            std::vector<std::optional<Weight>> weights;
+            // the first edge of a shortest path to the target
+            std::vector<EdgeId> next_edges;
+        };
+
+        TargetTree BuildTargetTree(VertexId to) const;
+        std::optional<Path> FindSpur(VertexId from, VertexId to, const TargetTree& tree,
+            const std::vector<char>& removed_vertices, const std::vector<char>& removed_edges) const;
+
+        const Graph& graph_;
+        ReverseIncidenceLists<Weight> reverse_incidence_;
+    };
+
+
+    template <typename Weight>
+    KShortestPaths<Weight>::KShortestPaths(const Graph& graph)
+        : graph_(graph)
+        , reverse_incidence_(graph)
+    {}
+
+    template <typename Weight>
+    typename KShortestPaths<Weight>::TargetTree KShortestPaths<Weight>::BuildTargetTree(VertexId to) const {
+        TargetTree tree{ std::vector<std::optional<Weight>>(graph_.GetVertexCount()),
+            std::vector<EdgeId>(graph_.GetVertexCount(), NO_EDGE) };
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        tree.weights[to] = 0;
+        queue.push({ 0, to });
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > *tree.weights[vertex]) {
+                continue;
+            }
+            for (const EdgeId edge_id : reverse_incidence_.GetIncomingEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight next_weight = weight + edge.weight;
+                if (!tree.weights[edge.from] || next_weight < *tree.weights[edge.from]) {
+                    tree.weights[edge.from] = next_weight;
+                    tree.next_edges[edge.from] = edge_id;
+                    queue.push({ next_weight, edge.from });
+                }
+            }
+        }
+        return tree;
+    }
+
+    template <typename Weight>
+    std::optional<typename KShortestPaths<Weight>::Path> KShortestPaths<Weight>::FindSpur(
+        VertexId from, VertexId to, const TargetTree& tree,
+        const std::vector<char>& removed_vertices, const std::vector<char>& removed_edges) const {
+        std::vector<std::optional<Weight>> weights(graph_.GetVertexCount());
+        std::vector<EdgeId> prev_edges(graph_.GetVertexCount(), NO_EDGE);
+        // ordered by the weight plus the distance to the target
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        weights[from] = 0;
+        queue.push({ *tree.weights[from], from });
+        while (!queue.empty()) {
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+            if (vertex == to) {
+                Path path{ *weights[to], {} };
+                for (VertexId cur = to; cur != from; cur = graph_.GetEdge(path.edges.back()).from) {
+                    path.edges.push_back(prev_edges[cur]);
+                }
+                std::reverse(path.edges.begin(), path.edges.end());
+                return path;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (removed_edges[edge_id] || removed_vertices[edge.to] || !tree.weights[edge.to]) {
+                    continue;
+                }
+                const Weight next_weight = *weights[vertex] + edge.weight;
+                if (!weights[edge.to] || next_weight < *weights[edge.to]) {
+                    weights[edge.to] = next_weight;
+                    prev_edges[edge.to] = edge_id;
+                    queue.push({ next_weight + *tree.weights[edge.to], edge.to });
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    template <typename Weight>
+    std::vector<typename KShortestPaths<Weight>::Path> KShortestPaths<Weight>::FindPaths(VertexId from, VertexId to, size_t k) const {
+        std::vector<Path> paths;
+        const TargetTree tree = BuildTargetTree(to);
+        if (k == 0 || !tree.weights[from]) {
+            return paths;
+        }
+
+        Path first{ *tree.weights[from], {} };
+        for (VertexId vertex = from; vertex != to; vertex = graph_.GetEdge(first.edges.back()).to) {
+            first.edges.push_back(tree.next_edges[vertex]);
+        }
+        paths.push_back(std::move(first));
+
+        const auto by_weight = [](const Path& lhs, const Path& rhs) {
+            return std::tie(lhs.weight, lhs.edges) > std::tie(rhs.weight, rhs.edges);
+        };
+        std::priority_queue<Path, std::vector<Path>, decltype(by_weight)> candidates(by_weight);
+        std::set<std::vector<EdgeId>> seen = { paths.front().edges };
+        std::vector<char> removed_vertices(graph_.GetVertexCount());
+        std::vector<char> removed_edges(graph_.GetEdgeCount());
+
+        while (paths.size() < k) {
+            // every vertex of the last path but the target starts a spur,
+            // the part of the path before it is kept as the root
+            const std::vector<EdgeId> last_edges = paths.back().edges;
+            VertexId spur_vertex = from;
+            Weight root_weight = 0;
+            for (size_t root_size = 0; root_size < last_edges.size(); ++root_size) {
+                for (const auto& path : paths) {
+                    if (path.edges.size() > root_size &&
+                        std::equal(last_edges.begin(), last_edges.begin() + root_size, path.edges.begin())) {
+                        removed_edges[path.edges[root_size]] = 1;
+                    }
+                }
+
+                if (auto spur = FindSpur(spur_vertex, to, tree, removed_vertices, removed_edges)) {
+                    Path candidate{ root_weight + spur->weight, {} };
+                    candidate.edges.reserve(root_size + spur->edges.size());
+                    candidate.edges.insert(candidate.edges.end(), last_edges.begin(), last_edges.begin() + root_size);
+                    candidate.edges.insert(candidate.edges.end(), spur->edges.begin(), spur->edges.end());
+                    if (seen.insert(candidate.edges).second) {
+                        candidates.push(std::move(candidate));
+                    }
+                }
+
+                for (const auto& path : paths) {
+                    if (path.edges.size() > root_size) {
+                        removed_edges[path.edges[root_size]] = 0;
+                    }
+                }
+                const auto& edge = graph_.GetEdge(last_edges[root_size]);
+                removed_vertices[spur_vertex] = 1;
+                root_weight += edge.weight;
+                spur_vertex = edge.to;
+            }
+            std::fill(removed_vertices.begin(), removed_vertices.end(), 0);
+
+            if (candidates.empty()) {
+                break;
+            }
+            paths.push_back(candidates.top());
+            candidates.pop();
+        }
+        return paths;
+    }
+
+}
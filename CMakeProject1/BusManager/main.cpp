@@ -3,131 +3,272 @@
 #include "manager.h"
 #include "utils.h"
 #include "requests.h"
+#include "json_index.h"
+#include "binary_network.h"
+#include "pipeline.h"
+
+#include <exception>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <sstream>
 
 using namespace std;
 
-const unordered_map<string, Request::ERequestType> ModifyRequestTypeByString = {
+const unordered_map<string_view, Request::ERequestType> ModifyRequestTypeByString = {
 	{"Stop", Request::ERequestType::ADD_STOP},
 	{"Bus", Request::ERequestType::ADD_BUS}
 };
 
-const unordered_map<string, Request::ERequestType> ReadRequestTypeByString = {
+const unordered_map<string_view, Request::ERequestType> ReadRequestTypeByString = {
 	{"Bus", Request::ERequestType::QUERY_BUS},
 	{"Stop", Request::ERequestType::QUERY_STOP},
 	{"Route", Request::ERequestType::QUERY_ROUTE}
 };
 
-RequestHolder CreateRequestHolder(Request::ERequestType type) {
+struct ProgramOptions {
+	PrintOptions Print;
+	bool IndexedParser = false;
+	size_t ParserThreads = 1;
+	// base_requests stored by --convert-base
+	string BasePath;
+	string ConvertBasePath;
+	// legacy line-based protocol, answers are printed as text
+	bool TextInput = false;
+	// answer stat requests while they are read, see RunPipeline
+	size_t PipelineWorkers = 0;
+	// capacity of the route answer cache, 0 disables it
+	size_t RouteCacheSize = BusManagerSettings().RouteCacheSize;
+	// print route cache hits and misses to cerr
+	bool RouteCacheStats = false;
+	ERouterType RouterType = ERouterType::FLOYD_WARSHALL;
+	string RouterIndexPath;
+};
+
+const unordered_map<string_view, ERouterType> RouterTypeByString = {
+	{"floyd", ERouterType::FLOYD_WARSHALL},
+	{"floyd-compact", ERouterType::FLOYD_WARSHALL_COMPACT},
+	{"hub-labels", ERouterType::HUB_LABELS},
+	{"dijkstra", ERouterType::BIDIRECTIONAL_DIJKSTRA}
+};
+
+ProgramOptions ParseProgramOptions(int argc, char* argv[]) {
+	ProgramOptions options;
+	for (int i = 1; i < argc; ++i) {
+		string_view arg = argv[i];
+		if (arg == "--compact") {
+			options.Print.Compact = true;
+		}
+		else if (arg == "--text") {
+			options.TextInput = true;
+		}
+		else if (arg == "--indexed") {
+			options.IndexedParser = true;
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			options.ParserThreads = stoul(argv[++i]);
+		}
+		else if (arg == "--pipeline" && i + 1 < argc) {
+			options.PipelineWorkers = max<size_t>(stoul(argv[++i]), 1);
+		}
+		else if (arg == "--route-cache" && i + 1 < argc) {
+			options.RouteCacheSize = stoul(argv[++i]);
+		}
+		else if (arg == "--route-cache-stats") {
+			options.RouteCacheStats = true;
+		}
+		else if (arg == "--router" && i + 1 < argc) {
+			options.RouterType = RouterTypeByString.at(argv[++i]);
+		}
+		else if (arg == "--router-index" && i + 1 < argc) {
+			options.RouterIndexPath = argv[++i];
+		}
+		else if (arg == "--base" && i + 1 < argc) {
+			options.BasePath = argv[++i];
+		}
+		else if (arg == "--convert-base" && i + 1 < argc) {
+			options.ConvertBasePath = argv[++i];
+		}
+		else if (arg == "--shortest") {
+			options.Print.NumberFormat = PrintOptions::ENumberFormat::SHORTEST;
+		}
+		else {
+			throw invalid_argument("unknown option " + string(arg));
+		}
+	}
+	return options;
+}
+
+template <typename Source>
+void AddRequest(RequestBatch& requests, Request::ERequestType type, const Source& source) {
 	switch (type) {
 		case Request::ERequestType::ADD_BUS:
-			return make_unique<AddBusRequest>();
+			requests.AddBuses.emplace_back().ReadInfo(source);
+			break;
 		case Request::ERequestType::ADD_STOP:
-			return make_unique<AddStopRequest>();
+			requests.AddStops.emplace_back().ReadInfo(source);
+			break;
 		case Request::ERequestType::QUERY_BUS:
-			return make_unique<ReadBusInfoRequest>();
+			get<ReadBusInfoRequest>(requests.Stats.emplace_back(ReadBusInfoRequest())).ReadInfo(source);
+			break;
 		case Request::ERequestType::QUERY_STOP:
-			return make_unique<ReadStopInfoRequest>();
+			get<ReadStopInfoRequest>(requests.Stats.emplace_back(ReadStopInfoRequest())).ReadInfo(source);
+			break;
 		case Request::ERequestType::QUERY_ROUTE:
-			return make_unique<ReadRouteInfoRequest>();
+			get<ReadRouteInfoRequest>(requests.Stats.emplace_back(ReadRouteInfoRequest())).ReadInfo(source);
+			requests.HasRouteQueries = true;
+			break;
 		default:
 			throw "undefined type";
 	}
 }
 
-void ReadRequestsCin(vector<RequestHolder>& requests, 
-	const unordered_map<string, Request::ERequestType>& RequestTypeByString) {
-	int queries_count;
-	cin >> queries_count;
+void ReadRequestsText(RequestBatch& requests, string_view& text,
+	const unordered_map<string_view, Request::ERequestType>& RequestTypeByString) {
+	int queries_count = StringUtils::ParseNumber<int>(StringUtils::ReadLine(text));
 	for (int i = 0; i < queries_count; ++i) {
-		string query_type_string;
-		cin >> query_type_string;
+		auto line = StringUtils::Trim(StringUtils::ReadLine(text));
+		auto space_pos = line.find(' ');
+		auto query_type_string = line.substr(0, space_pos);
 		assert(RequestTypeByString.count(query_type_string));
 		auto type = RequestTypeByString.at(query_type_string);
-		requests.push_back(CreateRequestHolder(type));
-		requests.back()->ReadInfo(cin);
+		AddRequest(requests, type, space_pos == string_view::npos ? string_view() : line.substr(space_pos + 1));
 	}
 }
 
-vector<RequestHolder> ReadAllRequestsCin() {
-	vector<RequestHolder> requests;
-	ReadRequestsCin(requests, ModifyRequestTypeByString);
-	ReadRequestsCin(requests, ReadRequestTypeByString);
+RequestBatch ReadAllRequestsText(istream& input) {
+	const auto buffer = ReadAll(input);
+	string_view text(buffer.data(), buffer.size());
+	RequestBatch requests;
+	ReadRequestsText(requests, text, ModifyRequestTypeByString);
+	ReadRequestsText(requests, text, ReadRequestTypeByString);
 	return requests;
 }
 
-void ReadRequestsJson(vector<RequestHolder>& requests, const Node& node,
-	const unordered_map<string, Request::ERequestType>& RequestTypeByString) {
+void ReadRequestsJson(RequestBatch& requests, const ArenaNode& node,
+	const unordered_map<string_view, Request::ERequestType>& RequestTypeByString) {
 	for (const auto& query_node : node.AsArray()) {
 		auto type = RequestTypeByString.at(query_node.AsMap().at("type").AsString());
-		requests.push_back(CreateRequestHolder(type));
-		requests.back()->ReadInfo(query_node);
+		AddRequest(requests, type, query_node);
 	}
 }
 
 
-pair<BusManagerSettings, vector<RequestHolder>> ReadAllRequestsJson() {
-	auto document = Load(cin);
-	vector<RequestHolder> requests;
+ArenaDocument LoadDocument(const ProgramOptions& options) {
+	if (options.ParserThreads > 1) {
+		return LoadParallel(cin, options.ParserThreads);
+	}
+	return options.IndexedParser ? LoadIndexed(cin) : LoadArena(cin);
+}
 
-	assert((int)document.GetRoot().AsMap().size() == 3);
+BusManagerSettings ReadSettings(const ArenaNode& node, const ProgramOptions& options) {
+	const auto& settings_info = node.AsMap();
+	BusManagerSettings settings(
+		static_cast<int>(settings_info.at("bus_wait_time").AsDouble()),
+		static_cast<int>(settings_info.at("bus_velocity").AsDouble())
+	);
+	settings.Print = options.Print;
+	settings.RouteCacheSize = options.RouteCacheSize;
+	settings.RouterType = options.RouterType;
+	settings.RouterIndexPath = options.RouterIndexPath;
+	return settings;
+}
 
-	const auto& modify_requests = document.GetRoot().AsMap().at("base_requests");
-	ReadRequestsJson(requests, modify_requests, ModifyRequestTypeByString);
+void ReadBinaryBase(RequestBatch& requests, const ProgramOptions& options) {
+	if (!options.BasePath.empty()) {
+		ifstream input(options.BasePath, ios::binary);
+		if (!input) {
+			throw runtime_error("cannot open " + options.BasePath);
+		}
+		BinaryNetwork::MakeRequests(BinaryNetwork::Load(input), requests);
+	}
+}
+
+pair<BusManagerSettings, RequestBatch> ReadAllRequestsJson(const ProgramOptions& options) {
+	auto document = LoadDocument(options);
+	RequestBatch requests;
+	ReadBinaryBase(requests, options);
+
+	if (document.GetRoot().AsMap().count("base_requests")) {
+		const auto& modify_requests = document.GetRoot().AsMap().at("base_requests");
+		ReadRequestsJson(requests, modify_requests, ModifyRequestTypeByString);
+	}
 
 	const auto& read_requests = document.GetRoot().AsMap().at("stat_requests");
+	requests.Stats.reserve(read_requests.AsArray().size());
 	ReadRequestsJson(requests, read_requests, ReadRequestTypeByString);
 
-	const auto& settings_info = document.GetRoot().AsMap().at("routing_settings").AsMap();
-	auto settings = BusManagerSettings(
-		static_cast<int>(settings_info.at("bus_wait_time").AsDouble()),
-		static_cast<int>(settings_info.at("bus_velocity").AsDouble())
-	);
-
-	return { settings, move(requests) };
+	return { ReadSettings(document.GetRoot().AsMap().at("routing_settings"), options), move(requests) };
 }
 
-vector<unique_ptr<Response>> GetResponses(
-	const BusManagerSettings& settings, const vector<RequestHolder>& requests) {
-	BusManager manager(settings);
-	vector<unique_ptr<Response>> responses;
-	
-	for (auto& request_holder : requests) {
-		if (request_holder->Type == Request::ERequestType::ADD_STOP) {
-			const auto& request = static_cast<const ModifyRequest&>(*request_holder);
-			request.Process(manager);
-		}
+void ConvertBaseRequests(const ProgramOptions& options) {
+	auto document = LoadDocument(options);
+	RequestBatch requests;
+	ReadRequestsJson(requests, document.GetRoot().AsMap().at("base_requests"), ModifyRequestTypeByString);
+
+	ofstream output(options.ConvertBasePath, ios::binary);
+	BinaryNetwork::Save(BinaryNetwork::BuildNetwork(requests), output);
+	if (!output) {
+		throw runtime_error("cannot write " + options.ConvertBasePath);
 	}
+}
 
-	for (auto& request_holder : requests) {
-		if (request_holder->Type == Request::ERequestType::ADD_BUS) {
-			const auto& request = static_cast<const ModifyRequest&>(*request_holder);
-			request.Process(manager);
-		}
+void ProcessModifyRequests(BusManager& manager, const RequestBatch& requests) {
+	for (const auto& request : requests.AddStops) {
+		request.Process(manager);
+	}
+	for (const auto& request : requests.AddBuses) {
+		request.Process(manager);
 	}
+}
 
-	manager.BuildRoutes();
+StatResponse ProcessStatRequest(BusManager& manager, const StatRequest& request) {
+	return visit([&manager](const auto& request) -> StatResponse {
+		return request.Process(manager);
+	}, request);
+}
 
-	for (auto& request_holder : requests) {
-		if (request_holder->Type == Request::ERequestType::QUERY_BUS) {
-			const auto& request = static_cast<const ReadBusInfoRequest&>(*request_holder);
-			responses.push_back(make_unique<BusInfoResponse>(request.Process(manager)));
-		}
-		else if (request_holder->Type == Request::ERequestType::QUERY_STOP) {
-			const auto& request = static_cast<const ReadStopInfoRequest&>(*request_holder);
-			responses.push_back(make_unique<StopInfoResponse>(request.Process(manager)));
-		}
-		else if (request_holder->Type == Request::ERequestType::QUERY_ROUTE) {
-			const auto& request = static_cast<const ReadRouteInfoRequest&>(*request_holder);
-			responses.push_back(make_unique<RouteInfoResponse>(request.Process(manager)));
+void PrintRouteCacheStats(const BusManager& manager) {
+	const auto stats = manager.GetRouteCacheStats();
+	cerr << "route cache: " << stats.Hits << " hits, " << stats.Misses << " misses\n";
+}
+
+vector<StatResponse> GetResponses(const BusManagerSettings& settings, const RequestBatch& requests,
+	bool print_cache_stats = false) {
+	BusManager manager(settings);
+	ProcessModifyRequests(manager, requests);
+
+	// the text protocol has no routing settings and no route queries
+	if (requests.HasRouteQueries) {
+		manager.BuildRoutes();
+	}
+
+	// identical requests differ only in id, each distinct one is answered once
+	// and its answer is copied for the rest
+	vector<StatResponse> responses;
+	responses.reserve(requests.Stats.size());
+	unordered_map<string, size_t> response_by_key;
+	for (const auto& request : requests.Stats) {
+		auto [it, inserted] = response_by_key.emplace(
+			visit([](const auto& request) { return request.GetKey(); }, request), responses.size());
+		if (inserted) {
+			responses.push_back(ProcessStatRequest(manager, request));
+			continue;
 		}
+		const auto request_id = visit([](const auto& request) { return request.GetRequestId(); }, request);
+		visit([request_id](auto& response) { response.SetRequestId(request_id); },
+			responses.emplace_back(responses[it->second]));
+	}
+	if (print_cache_stats) {
+		PrintRouteCacheStats(manager);
 	}
 	return responses;
 }
 
-void PrintResponsesCout(const vector<unique_ptr<Response>>& responses) {
-	for (const auto& response_ptr: responses) {
-		if (response_ptr->Type == Response::EResponseType::BUS_INFO) {
-			const auto& response = static_cast<const BusInfoResponse&>(*response_ptr);
+void PrintResponsesCout(const vector<StatResponse>& responses) {
+	for (const auto& response_variant : responses) {
+		if (holds_alternative<BusInfoResponse>(response_variant)) {
+			const auto& response = get<BusInfoResponse>(response_variant);
 			cout << "Bus " << response.Name << ": ";
 			if (response.Info) {
 				cout << response.Info.value().CntStops << " stops on route, " <<
@@ -140,8 +281,8 @@ void PrintResponsesCout(const vector<unique_ptr<Response>>& responses) {
 				cout << "not found\n";
 			}
 		}
-		else if (response_ptr->Type == Response::EResponseType::STOP_INFO) {
-			const auto& response = static_cast<const StopInfoResponse&>(*response_ptr);
+		else if (holds_alternative<StopInfoResponse>(response_variant)) {
+			const auto& response = get<StopInfoResponse>(response_variant);
 			cout << "Stop " << response.Name << ": ";
 			if (response.Info) {
 				if (response.Info.value().Buses.empty()) {
@@ -159,69 +300,213 @@ void PrintResponsesCout(const vector<unique_ptr<Response>>& responses) {
 				cout << "not found\n";
 			}
 		}
-		else if (response_ptr->Type == Response::EResponseType::ROUTE_INFO) {
-			throw runtime_error("Not implemented Response to print");
-		}
 		else {
 			throw runtime_error("Not implemented Response to print");
 		}
 	}
 }
 
-void PrintResponsesJson(const vector<unique_ptr<Response>>& responses) {
-	auto result_vec = vector<Node>();
+Node MakeResponseNode(const BusInfoResponse& response) {
+	auto cur_node = map<string, Node>{};
+	cur_node["request_id"] = Node(static_cast<double>(response.Request_id));
+	if (response.Info) {
+		cur_node["stop_count"] = Node(static_cast<double>(response.Info.value().CntStops));
+		cur_node["unique_stop_count"] = Node(static_cast<double>(response.Info.value().UniqueStops));
+		cur_node["curvature"] = Node(response.Info.value().Curvature);
+		cur_node["route_length"] = Node(response.Info.value().PathLength);
+	}
+	else {
+		cur_node["error_message"] = Node("not found"s);
+	}
+	return Node(move(cur_node));
+}
 
-	for (const auto& response_ptr: responses) {
-		Node response_node;
-		if (response_ptr->Type == Response::EResponseType::BUS_INFO) {
-			auto cur_node = map<string, Node>{};
-			const auto& response = static_cast<const BusInfoResponse&>(*response_ptr);
-			cur_node["request_id"] = Node(static_cast<double>(response.Request_id));
-			if (response.Info) {
-				cur_node["stop_count"] = Node(static_cast<double>(response.Info.value().CntStops));
-				cur_node["unique_stop_count"] = Node(static_cast<double>(response.Info.value().UniqueStops));
-				cur_node["curvature"] = Node(response.Info.value().Curvature);
-				cur_node["route_length"] = Node(response.Info.value().PathLength);
+Node MakeResponseNode(const StopInfoResponse& response) {
+	auto cur_node = map<string, Node>{};
+	cur_node["request_id"] = Node(static_cast<double>(response.Request_id));
+	if (response.Info) {
+		auto buses_vector = vector<Node>();
+		buses_vector.reserve(response.Info.value().Buses.size());
+		for (const auto& bus_name : response.Info.value().Buses) {
+			buses_vector.push_back(Node(bus_name));
+		}
+		cur_node["buses"] = move(buses_vector);
+	}
+	else {
+		cur_node["error_message"] = Node("not found"s);
+	}
+	return Node(move(cur_node));
+}
+
+void PrintResponse(Printer& printer, const BusInfoResponse& response) {
+	printer.Print(MakeResponseNode(response));
+}
+
+void PrintResponse(Printer& printer, const StopInfoResponse& response) {
+	printer.Print(MakeResponseNode(response));
+}
+
+void PrintResponse(Printer& printer, const RouteInfoResponse& response) {
+	printer.Write(response.Info->BeforeRequestId);
+	printer.WriteNumber(static_cast<double>(response.Request_id));
+	printer.Write(response.Info->AfterRequestId);
+}
+
+void PrintResponse(Printer& printer, const StatResponse& response) {
+	visit([&printer](const auto& response) {
+		PrintResponse(printer, response);
+	}, response);
+}
+
+// Prints the responses as one JSON array, the same way Node::Print would,
+// without collecting them into a single tree first
+void PrintResponsesJson(const vector<StatResponse>& responses, const PrintOptions& options) {
+	Printer printer(cout, options);
+	printer.Write('[');
+	printer.NewLine();
+	for (size_t i = 0; i < responses.size(); ++i) {
+		PrintResponse(printer, responses[i]);
+		if (i + 1 < responses.size()) {
+			printer.Write(',');
+		}
+		printer.NewLine();
+	}
+	printer.Write(']');
+}
+
+// Stat requests go through three stages running at the same time:
+// a parser thread reads them one by one into a bounded queue, a pool of
+// workers answers them and serializes the answers, and the writer prints
+// them in input order. Base requests are applied before the stages start.
+void RunPipeline(const ProgramOptions& options) {
+	static const size_t QUEUE_CAPACITY = 1024;
+
+	const auto buffer = ReadAll(cin);
+	string_view settings_text, base_text, stat_text;
+	for (const auto& [key, value] : SplitObject({ buffer.data(), buffer.size() })) {
+		if (key == "routing_settings") {
+			settings_text = value;
+		}
+		else if (key == "base_requests") {
+			base_text = value;
+		}
+		else if (key == "stat_requests") {
+			stat_text = value;
+		}
+	}
+
+	Arena arena;
+	BusManager manager(ReadSettings(ParseArena(settings_text, arena), options));
+	{
+		RequestBatch requests;
+		ReadBinaryBase(requests, options);
+		if (!base_text.empty()) {
+			ReadRequestsJson(requests, ParseArena(base_text, arena), ModifyRequestTypeByString);
+		}
+		ProcessModifyRequests(manager, requests);
+	}
+	once_flag routes_built;
+
+	BoundedQueue<pair<size_t, StatRequest>> requests(QUEUE_CAPACITY);
+	ReorderBuffer<string> answers(QUEUE_CAPACITY);
+	mutex error_mutex;
+	exception_ptr error;
+	auto guard = [&](auto stage) {
+		return [&, stage] {
+			try {
+				stage();
 			}
-			else {
-				cur_node["error_message"] = Node("not found"s);
+			catch (...) {
+				lock_guard lock(error_mutex);
+				if (!error) {
+					error = current_exception();
+				}
+				requests.Close();
+				answers.Close();
 			}
-			response_node = Node(cur_node);
+		};
+	};
+
+	auto parser = async(launch::async, guard([&] {
+		ArrayReader reader(stat_text);
+		size_t seq = 0;
+		for (auto text = reader.Next(); !text.empty(); text = reader.Next()) {
+			RequestBatch batch;
+			Arena request_arena(1 << 10);
+			const auto node = ParseArena(text, request_arena);
+			AddRequest(batch, ReadRequestTypeByString.at(node.AsMap().at("type").AsString()), node);
+			requests.Push({ seq++, move(batch.Stats.back()) });
 		}
-		else if (response_ptr->Type == Response::EResponseType::STOP_INFO) {
-			auto cur_node = map<string, Node>{};
-			const auto& response = static_cast<const StopInfoResponse&>(*response_ptr);
-			cur_node["request_id"] = Node(static_cast<double>(response.Request_id));
-			if (response.Info) {
-				auto buses_vector = vector<Node>();
-				for (const auto& bus_name : response.Info.value().Buses) {
-					buses_vector.push_back(Node(bus_name));
+		requests.Close();
+	}));
+
+	vector<future<void>> workers;
+	for (size_t i = 0; i < options.PipelineWorkers; ++i) {
+		workers.push_back(async(launch::async, guard([&] {
+			ostringstream stream;
+			Printer printer(stream, options.Print);
+			while (auto request = requests.Pop()) {
+				if (holds_alternative<ReadRouteInfoRequest>(request->second)) {
+					call_once(routes_built, [&manager] { manager.BuildRoutes(); });
 				}
-				cur_node["buses"] = buses_vector;
+				PrintResponse(printer, ProcessStatRequest(manager, request->second));
+				printer.Flush();
+				answers.Put(request->first, stream.str());
+				stream.str({});
 			}
-			else {
-				cur_node["error_message"] = Node("not found"s);
+		})));
+	}
+
+	auto writer = async(launch::async, guard([&] {
+		Printer printer(cout, options.Print);
+		printer.Write('[');
+		printer.NewLine();
+		bool first = true;
+		while (auto answer = answers.Take()) {
+			if (!first) {
+				printer.Write(',');
+				printer.NewLine();
 			}
-			response_node = Node(cur_node);
+			printer.Write(*answer);
+			first = false;
 		}
-		else if (response_ptr->Type == Response::EResponseType::ROUTE_INFO) {
-			const auto& response = static_cast<const RouteInfoResponse&>(*response_ptr);
-			response_node = response.Info;
+		if (!first) {
+			printer.NewLine();
 		}
-		else {
-			throw runtime_error("Not implemented Response to print");
-		}
-		result_vec.push_back(response_node);
-	}
+		printer.Write(']');
+	}));
 
-	auto result_node = Node(result_vec);
-	result_node.Print(cout);
+	parser.get();
+	for (auto& worker : workers) {
+		worker.get();
+	}
+	answers.Close();
+	writer.get();
+	if (error) {
+		rethrow_exception(error);
+	}
+	if (options.RouteCacheStats) {
+		PrintRouteCacheStats(manager);
+	}
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 	//FILE* file;
 	//freopen_s(&file, "C:\\Users\\Admin\\source\\repos\\Alexandr-TS\\CourseraBrownBelt\\CMakeProject1\\BusManager\\a.in", "r", stdin);
-	auto requests = ReadAllRequestsJson();
-	const auto responses = GetResponses(requests.first, move(requests.second));
-	PrintResponsesJson(responses);
+	const auto options = ParseProgramOptions(argc, argv);
+	if (!options.ConvertBasePath.empty()) {
+		ConvertBaseRequests(options);
+		return 0;
+	}
+	if (options.TextInput) {
+		PrintResponsesCout(GetResponses(BusManagerSettings(), ReadAllRequestsText(cin)));
+		return 0;
+	}
+	if (options.PipelineWorkers) {
+		RunPipeline(options);
+		return 0;
+	}
+	const auto requests = ReadAllRequestsJson(options);
+	const auto responses = GetResponses(requests.first, requests.second, options.RouteCacheStats);
+	PrintResponsesJson(responses, options.Print);
 }
@@ -2,6 +2,11 @@
 
 #include "json.h"
 #include "router.h"
+#include "hub_label_router.h"
+#include "bidirectional_router.h"
+#include "raptor_router.h"
+#include "k_shortest_paths.h"
+#include "route_cache.h"
 
 #include <cassert>
 #include <memory>
@@ -15,11 +20,17 @@
 #include <optional>
 #include <cmath>
 #include <functional>
+#include <mutex>
+#include <fstream>
+#include <variant>
 
 using namespace std;
 
 const double PI = 3.1415926535;
 const double RADIUS = 6371;
+// Upper bound for the number of alternative routes ("k") in one answer;
+// larger requests are answered with this many routes
+const size_t MAX_ROUTE_COUNT = 16;
 
 struct Location {
 	double Latitude = 0.0;
@@ -56,12 +67,12 @@ class RouteInfoResponse : public Response {
 public:
 	RouteInfoResponse() : Response(Response::EResponseType::ROUTE_INFO) {}
 
-	RouteInfoResponse(Json::Node&& node)
+	RouteInfoResponse(SerializedRoutePtr info)
 		: Response(Response::EResponseType::ROUTE_INFO)
-		, Info(node)
+		, Info(move(info))
 	{}
 
-	Json::Node Info;
+	SerializedRoutePtr Info;
 };
 
 class BusInfoResponse: public Response {
@@ -103,6 +114,8 @@ public:
 	optional<BusesInfo> Info;
 };
 
+using StatResponse = variant<BusInfoResponse, StopInfoResponse, RouteInfoResponse>;
+
 struct Stop {
 	Location StopLocation;
 	set<string> BusesNames;
@@ -155,6 +168,22 @@ struct Bus {
 };
 
 
+// what a route request optimizes
+enum class ERouteMode {
+	FASTEST,
+	MIN_TRANSFERS,
+	// every journey for which no other one is both faster and has fewer transfers
+	PARETO
+};
+
+enum class ERouterType {
+	FLOYD_WARSHALL,
+	// Floyd-Warshall with a float weight matrix
+	FLOYD_WARSHALL_COMPACT,
+	HUB_LABELS,
+	BIDIRECTIONAL_DIJKSTRA
+};
+
 struct BusManagerSettings {
 	BusManagerSettings() 
 		: BusWaitTime(0)
@@ -168,12 +197,20 @@ struct BusManagerSettings {
 
 	int BusWaitTime;
 	int BusVelocity;
+	// route answers are serialized by the manager and cached
+	Json::PrintOptions Print;
+	size_t RouteCacheSize = 1 << 14;
+	ERouterType RouterType = ERouterType::FLOYD_WARSHALL;
+	// hub labels are read from this file when it exists and written to it otherwise,
+	// an index built for another network is rejected
+	string RouterIndexPath;
 };
 
 class BusManager {
 public:
 	BusManager(const BusManagerSettings& settings)
-		: Settings(settings)
+		: RouteResponses(settings.RouteCacheSize)
+		, Settings(settings)
 	{}
 
 	void AddStop(const string& name, Location location, const unordered_map<string, double>& dist_by_stop) {
@@ -194,7 +231,10 @@ public:
 		}
 	}
 
-	BusInfoResponse GetBusInfoResponse(const string& bus_name) {
+	// Queries only read the manager, so they may run on several threads
+	// once all stops and buses are added and routes are built
+
+	BusInfoResponse GetBusInfoResponse(const string& bus_name) const {
 		auto iter = Buses.find(bus_name);
 		if (iter == Buses.end()) {
 			return { bus_name, nullopt };
@@ -202,7 +242,7 @@ public:
 		return iter->second.GetInfo(bus_name);
 	}
 
-	StopInfoResponse GetStopInfoResponse(const string& stop_name) {
+	StopInfoResponse GetStopInfoResponse(const string& stop_name) const {
 		auto iter = Stops.find(stop_name);
 		if (iter == Stops.end()) {
 			return StopInfoResponse{ stop_name, nullopt };
@@ -210,40 +250,30 @@ public:
 		return StopInfoResponse{ stop_name, StopInfoResponse::BusesInfo{ iter->second.BusesNames } };
 	}
 
-	RouteInfoResponse GetRouteResponse(const string& stop_from, const string& stop_to) {
-		using namespace Json;
-
-		size_t from_id = StopIdByName[stop_from];
-		size_t to_id = StopIdByName[stop_to];
-		auto route = RouteBuilder->BuildRoute(from_id, to_id);
-		if (!route) {
-			auto node_map = map<string, Node>();
-			node_map["error_message"] = Node("not found"s);
-			return RouteInfoResponse(Node(node_map));
+	// route_count > 1 asks for alternative routes in the fastest mode,
+	// at most MAX_ROUTE_COUNT of them
+	RouteInfoResponse GetRouteResponse(const string& stop_from, const string& stop_to,
+		ERouteMode mode = ERouteMode::FASTEST, size_t route_count = 1) const {
+		auto from_it = StopIdByName.find(stop_from);
+		auto to_it = StopIdByName.find(stop_to);
+		if (from_it == StopIdByName.end() || to_it == StopIdByName.end()) {
+			return RouteInfoResponse(SerializeRoute(nullopt));
 		}
+		route_count = mode == ERouteMode::FASTEST ? clamp<size_t>(route_count, 1, MAX_ROUTE_COUNT) : 1;
+		const RouteCache::Key key{ from_it->second, to_it->second, static_cast<uint32_t>(mode), route_count };
+		return RouteInfoResponse(RouteResponses.Get(key, [&] {
+			if (route_count > 1) {
+				return SerializeRoutes(GetAlternativesBuilder().FindPaths(key.From, key.To, route_count));
+			}
+			if (mode == ERouteMode::FASTEST) {
+				return SerializeRoute(RouteBuilder->BuildRoute(key.From, key.To));
+			}
+			return SerializeJourneys(GetJourneyBuilder().BuildJourneys(key.From, key.To), mode);
+		}));
+	}
 
-		auto node_map = map<string, Node>();
-		auto result = route.value();
-		node_map["total_time"] = Node(result.weight);
-		auto node_map_items = vector<Node>();
-		vector<int> edges_ids;
-		for (size_t i = 0; i < result.edge_count; ++i) {
-			auto edge_id = RouteBuilder->GetRouteEdge(result.id, i);
-			auto wait_node_map = map<string, Node>();
-			wait_node_map["time"] = Node(static_cast<double>(Settings.BusWaitTime));
-			wait_node_map["type"] = Node("Wait"s);
-			wait_node_map["stop_name"] = Node(Edges[edge_id].StopFrom);
-			node_map_items.push_back(Node(wait_node_map));
-
-			auto ride_node_map = map<string, Node>();
-			ride_node_map["bus"] = Node(Edges[edge_id].BusName);
-			ride_node_map["type"] = Node("Bus"s);
-			ride_node_map["time"] = Node(Edges[edge_id].Weight - Settings.BusWaitTime);
-			ride_node_map["span_count"] = Node(Edges[edge_id].SpanCount);
-			node_map_items.push_back(Node(ride_node_map));
-		}
-		node_map["items"] = Node(node_map_items);
-		return RouteInfoResponse(Node(node_map));
+	RouteCache::Stats GetRouteCacheStats() const {
+		return RouteResponses.GetStats();
 	}
 	
 	void BuildRoutes() {
@@ -252,6 +282,7 @@ public:
 		size_t cur_stop_idx = 0;
 		for (const auto& [name, Stop] : Stops) {
 			StopIdByName[name] = cur_stop_idx++;
+			StopNames.push_back(name);
 		}
 
 		GraphPtr = make_shared<DirectedWeightedGraph<double>>(Stops.size());
@@ -285,10 +316,174 @@ public:
 			Edges.push_back({ dist, from_stop, to_stop, bus_name, edge_id, span_count });
 		}
 
-		RouteBuilder = make_unique<Graph::Router<double>>(*GraphPtr);
+		RouteBuilder = MakeRouter();
 	}
 
 private:
+	// alternatives and journeys are built on the first request asking for them
+
+	const Graph::KShortestPaths<double>& GetAlternativesBuilder() const {
+		call_once(AlternativesBuilt, [this] {
+			AlternativesBuilder = make_unique<Graph::KShortestPaths<double>>(*GraphPtr);
+		});
+		return *AlternativesBuilder;
+	}
+
+	const Graph::RaptorRouter<double>& GetJourneyBuilder() const {
+		call_once(JourneysBuilt, [this] {
+			vector<Graph::RaptorRouter<double>::Line> lines;
+			for (const auto& [bus_name, bus] : Buses) {
+				auto& line = lines.emplace_back();
+				for (size_t pos = 0; pos < bus.Stops.size(); ++pos) {
+					line.stops.push_back(StopIdByName.at(bus.Stops[pos]));
+					if (pos + 1 < bus.Stops.size()) {
+						line.segment_weights.push_back(DistancesBetweenStops.at(bus.Stops[pos]).at(bus.Stops[pos + 1]) /
+							(Settings.BusVelocity * 1000 / 60.));
+					}
+				}
+				LineNames.push_back(bus_name);
+			}
+			JourneyBuilder = make_unique<Graph::RaptorRouter<double>>(Stops.size(), move(lines), Settings.BusWaitTime);
+		});
+		return *JourneyBuilder;
+	}
+
+	unique_ptr<Graph::IRouter<double>> MakeRouter() const {
+		using namespace Graph;
+
+		if (Settings.RouterType == ERouterType::FLOYD_WARSHALL) {
+			return make_unique<Router<double>>(*GraphPtr);
+		}
+		if (Settings.RouterType == ERouterType::FLOYD_WARSHALL_COMPACT) {
+			return make_unique<Router<double, float>>(*GraphPtr);
+		}
+		if (Settings.RouterType == ERouterType::BIDIRECTIONAL_DIJKSTRA) {
+			return make_unique<BidirectionalRouter<double>>(*GraphPtr);
+		}
+
+		if (!Settings.RouterIndexPath.empty()) {
+			ifstream input(Settings.RouterIndexPath, ios::binary);
+			if (input) {
+				return make_unique<HubLabelRouter<double>>(*GraphPtr, input);
+			}
+		}
+		auto router = make_unique<HubLabelRouter<double>>(*GraphPtr);
+		if (!Settings.RouterIndexPath.empty()) {
+			ofstream output(Settings.RouterIndexPath, ios::binary);
+			router->Save(output);
+			if (!output) {
+				throw runtime_error("cannot write " + Settings.RouterIndexPath);
+			}
+		}
+		return router;
+	}
+
+	SerializedRoutePtr SerializeRoute(optional<Graph::IRouter<double>::RouteInfo> route) const {
+		using namespace Json;
+
+		if (!route) {
+			auto node_map = map<string, Node>();
+			node_map["error_message"] = Node("not found"s);
+			return SerializeRouteNode(node_map);
+		}
+
+		auto node_map = map<string, Node>();
+		auto result = route.value();
+		node_map["total_time"] = Node(result.weight);
+		auto node_map_items = vector<Node>();
+		node_map_items.reserve(2 * result.edge_count);
+		for (size_t i = 0; i < result.edge_count; ++i) {
+			const auto& edge = Edges[RouteBuilder->GetRouteEdge(result.id, i)];
+			AddRideItems(node_map_items, edge.StopFrom, edge.BusName, edge.Weight - Settings.BusWaitTime, edge.SpanCount);
+		}
+		RouteBuilder->ReleaseRoute(result.id);
+		node_map["items"] = Node(move(node_map_items));
+		return SerializeRouteNode(node_map);
+	}
+
+	SerializedRoutePtr SerializeRoutes(const vector<Graph::KShortestPaths<double>::Path>& paths) const {
+		using namespace Json;
+
+		if (paths.empty()) {
+			return SerializeRoute(nullopt);
+		}
+
+		auto route_nodes = vector<Node>();
+		route_nodes.reserve(paths.size());
+		for (const auto& path : paths) {
+			auto node_map = map<string, Node>();
+			node_map["total_time"] = Node(path.weight);
+			auto node_map_items = vector<Node>();
+			node_map_items.reserve(2 * path.edges.size());
+			for (const auto edge_id : path.edges) {
+				const auto& edge = Edges[edge_id];
+				AddRideItems(node_map_items, edge.StopFrom, edge.BusName, edge.Weight - Settings.BusWaitTime, edge.SpanCount);
+			}
+			node_map["items"] = Node(move(node_map_items));
+			route_nodes.push_back(Node(move(node_map)));
+		}
+		auto node_map = map<string, Node>();
+		node_map["routes"] = Node(move(route_nodes));
+		return SerializeRouteNode(node_map);
+	}
+
+	SerializedRoutePtr SerializeJourneys(const vector<Graph::RaptorRouter<double>::Journey>& journeys,
+		ERouteMode mode) const {
+		using namespace Json;
+
+		if (journeys.empty()) {
+			return SerializeRoute(nullopt);
+		}
+
+		auto make_journey_map = [this](const Graph::RaptorRouter<double>::Journey& journey) {
+			auto node_map = map<string, Node>();
+			node_map["total_time"] = Node(journey.weight);
+			auto node_map_items = vector<Node>();
+			node_map_items.reserve(2 * journey.rides.size());
+			for (const auto& ride : journey.rides) {
+				AddRideItems(node_map_items, StopNames[JourneyBuilder->GetLine(ride.line).stops[ride.board_pos]],
+					LineNames[ride.line], ride.weight, static_cast<int>(ride.alight_pos - ride.board_pos));
+			}
+			node_map["items"] = Node(move(node_map_items));
+			node_map["transfers"] = Node(static_cast<double>(journey.rides.empty() ? 0 : journey.rides.size() - 1));
+			return node_map;
+		};
+
+		if (mode == ERouteMode::MIN_TRANSFERS) {
+			return SerializeRouteNode(make_journey_map(journeys.front()));
+		}
+		auto journey_nodes = vector<Node>();
+		for (const auto& journey : journeys) {
+			journey_nodes.push_back(Node(make_journey_map(journey)));
+		}
+		auto node_map = map<string, Node>();
+		node_map["journeys"] = Node(move(journey_nodes));
+		return SerializeRouteNode(node_map);
+	}
+
+	void AddRideItems(vector<Json::Node>& items, const string& stop_from, const string& bus_name,
+		double time, int span_count) const {
+		using namespace Json;
+
+		auto wait_node_map = map<string, Node>();
+		wait_node_map["time"] = Node(static_cast<double>(Settings.BusWaitTime));
+		wait_node_map["type"] = Node("Wait"s);
+		wait_node_map["stop_name"] = Node(stop_from);
+		items.push_back(Node(move(wait_node_map)));
+
+		auto ride_node_map = map<string, Node>();
+		ride_node_map["bus"] = Node(bus_name);
+		ride_node_map["type"] = Node("Bus"s);
+		ride_node_map["time"] = Node(time);
+		ride_node_map["span_count"] = Node(static_cast<double>(span_count));
+		items.push_back(Node(move(ride_node_map)));
+	}
+
+	SerializedRoutePtr SerializeRouteNode(const map<string, Json::Node>& node_map) const {
+		auto [before, after] = Json::PrintWithHole(node_map, "request_id", Settings.Print);
+		return make_shared<SerializedRoute>(SerializedRoute{ move(before), move(after) });
+	}
+
 	struct EdgeInfo {
 		double Weight;
 		string StopFrom;
@@ -300,8 +495,15 @@ private:
 
 	vector<EdgeInfo> Edges;
 	unordered_map<string, size_t> StopIdByName;
-	unique_ptr<Graph::Router<double>> RouteBuilder;
+	unique_ptr<Graph::IRouter<double>> RouteBuilder;
+	mutable unique_ptr<Graph::KShortestPaths<double>> AlternativesBuilder;
+	mutable once_flag AlternativesBuilt;
+	vector<string> StopNames;
+	mutable vector<string> LineNames;
+	mutable unique_ptr<Graph::RaptorRouter<double>> JourneyBuilder;
+	mutable once_flag JourneysBuilt;
 	shared_ptr<Graph::DirectedWeightedGraph<double>> GraphPtr;
+	mutable RouteCache RouteResponses;
 
 	unordered_map<string, Stop> Stops;
 	unordered_map<string, Bus> Buses;
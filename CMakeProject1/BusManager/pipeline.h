@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+using namespace std;
+
+// Blocking FIFO with a fixed capacity shared between threads
+template <typename T>
+class BoundedQueue {
+public:
+	explicit BoundedQueue(size_t capacity)
+		: Capacity(capacity)
+	{}
+
+	// Waits while the queue is full; values pushed after Close are dropped
+	void Push(T value) {
+		unique_lock lock(Mutex);
+		NotFull.wait(lock, [this] { return Items.size() < Capacity || Closed; });
+		if (Closed) {
+			return;
+		}
+		Items.push_back(move(value));
+		NotEmpty.notify_one();
+	}
+
+	// Waits for a value; nullopt once the queue is closed and empty
+	optional<T> Pop() {
+		unique_lock lock(Mutex);
+		NotEmpty.wait(lock, [this] { return !Items.empty() || Closed; });
+		if (Items.empty()) {
+			return nullopt;
+		}
+		T value = move(Items.front());
+		Items.pop_front();
+		NotFull.notify_one();
+		return value;
+	}
+
+	void Close() {
+		lock_guard lock(Mutex);
+		Closed = true;
+		NotEmpty.notify_all();
+		NotFull.notify_all();
+	}
+
+private:
+	size_t Capacity;
+	deque<T> Items;
+	bool Closed = false;
+	mutex Mutex;
+	condition_variable NotEmpty;
+	condition_variable NotFull;
+};
+
+// Gives values away in the order of their sequence numbers, while they may
+// arrive in any order. A producer can be at most Capacity values ahead of
+// the consumer, so the buffer stays bounded.
+template <typename T>
+class ReorderBuffer {
+public:
+	explicit ReorderBuffer(size_t capacity)
+		: Capacity(capacity)
+	{}
+
+	void Put(size_t seq, T value) {
+		unique_lock lock(Mutex);
+		Changed.wait(lock, [this, seq] { return seq < NextSeq + Capacity || Closed; });
+		if (Closed) {
+			return;
+		}
+		Items.emplace(seq, move(value));
+		Changed.notify_all();
+	}
+
+	// Waits for the next value; nullopt once closed and the next one is missing
+	optional<T> Take() {
+		unique_lock lock(Mutex);
+		Changed.wait(lock, [this] { return Items.count(NextSeq) || Closed; });
+		auto it = Items.find(NextSeq);
+		if (it == Items.end()) {
+			return nullopt;
+		}
+		T value = move(it->second);
+		Items.erase(it);
+		++NextSeq;
+		Changed.notify_all();
+		return value;
+	}
+
+	void Close() {
+		lock_guard lock(Mutex);
+		Closed = true;
+		Changed.notify_all();
+	}
+
+private:
+	size_t Capacity;
+	size_t NextSeq = 0;
+	map<size_t, T> Items;
+	bool Closed = false;
+	mutex Mutex;
+	condition_variable Changed;
+};
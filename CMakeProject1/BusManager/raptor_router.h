@@ -0,0 +1,186 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+    // Round based router over lines (RAPTOR without timetables): round k finds
+    // the best arrival at every stop with at most k rides. Each boarding costs
+    // board_weight, riding between neighbouring stops costs the segment weight.
+    // A query returns the Pareto set of (weight, rides) journeys.
+    template <typename Weight>
+    class RaptorRouter {
+    public:
+        struct Line {
+            std::vector<VertexId> stops;
+            // segment_weights[i] is the weight of the ride from stops[i] to stops[i + 1]
+            std::vector<Weight> segment_weights;
+        };
+
+        struct Ride {
+            size_t line;
+            size_t board_pos;
+            size_t alight_pos;
+            // without the boarding weight
+            Weight weight;
+        };
+
+        struct Journey {
+            Weight weight;
+            std::vector<Ride> rides;
+        };
+
+        RaptorRouter(size_t vertex_count, std::vector<Line> lines, Weight board_weight);
+
+        // journeys ordered by the number of rides, each one faster than the previous
+        std::vector<Journey> BuildJourneys(VertexId from, VertexId to) const;
+
+        const Line& GetLine(size_t line) const {
+            return lines_[line];
+        }
+
+    private:
+        static constexpr size_t NO_LINE = std::numeric_limits<size_t>::max();
+
+        struct Label {
+            Weight weight;
+            // the round that set the label, the ride of that round
+            size_t round = 0;
+            size_t line = NO_LINE;
+            size_t board_pos = 0;
+            size_t alight_pos = 0;
+        };
+
+        Journey Unpack(const std::vector<std::vector<std::optional<Label>>>& labels, size_t round, VertexId to) const;
+
+        size_t vertex_count_;
+        std::vector<Line> lines_;
+        // (line, position) pairs of every stop
+        std::vector<std::vector<std::pair<size_t, size_t>>> lines_by_stop_;
+        Weight board_weight_;
+    };
+
+
+    template <typename Weight>
+    RaptorRouter<Weight>::RaptorRouter(size_t vertex_count, std::vector<Line> lines, Weight board_weight)
+        : vertex_count_(vertex_count)
+        , lines_(std::move(lines))
+        , lines_by_stop_(vertex_count)
+        , board_weight_(board_weight)
+    {
+        for (size_t line = 0; line < lines_.size(); ++line) {
+            for (size_t pos = 0; pos < lines_[line].stops.size(); ++pos) {
+                lines_by_stop_[lines_[line].stops[pos]].push_back({ line, pos });
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::vector<typename RaptorRouter<Weight>::Journey> RaptorRouter<Weight>::BuildJourneys(VertexId from, VertexId to) const {
+        std::vector<Journey> journeys;
+        if (from == to) {
+            journeys.push_back(Journey{ 0, {} });
+            return journeys;
+        }
+
+        // labels[k][stop] is the best arrival with at most k rides
+        std::vector<std::vector<std::optional<Label>>> labels(1, std::vector<std::optional<Label>>(vertex_count_));
+        std::vector<std::optional<Weight>> best(vertex_count_);
+        labels[0][from] = Label{ 0 };
+        best[from] = 0;
+
+        std::vector<VertexId> marked = { from };
+        std::vector<size_t> first_marked_pos(lines_.size(), NO_LINE);
+        std::vector<size_t> queued_lines;
+        std::vector<char> is_marked(vertex_count_);
+
+        for (size_t round = 1; !marked.empty(); ++round) {
+            // lines passing the stops improved in the previous round,
+            // each scanned from its first such stop
+            queued_lines.clear();
+            for (const VertexId stop : marked) {
+                for (const auto& [line, pos] : lines_by_stop_[stop]) {
+                    if (first_marked_pos[line] == NO_LINE) {
+                        queued_lines.push_back(line);
+                        first_marked_pos[line] = pos;
+                    }
+                    else {
+                        first_marked_pos[line] = std::min(first_marked_pos[line], pos);
+                    }
+                }
+            }
+            marked.clear();
+
+            labels.push_back(labels.back());
+            const auto& previous = labels[round - 1];
+            auto& current = labels[round];
+
+            for (const size_t line : queued_lines) {
+                const auto& stops = lines_[line].stops;
+                const auto& segment_weights = lines_[line].segment_weights;
+                std::optional<Weight> on_board;
+                size_t board_pos = 0;
+                for (size_t pos = std::exchange(first_marked_pos[line], NO_LINE); pos < stops.size(); ++pos) {
+                    const VertexId stop = stops[pos];
+                    if (on_board) {
+                        const Weight arrival = *on_board;
+                        // a journey slower than the best one to the target is never needed
+                        if ((!best[stop] || arrival < *best[stop]) && (!best[to] || arrival < *best[to])) {
+                            best[stop] = arrival;
+                            current[stop] = Label{ arrival, round, line, board_pos, pos };
+                            if (!is_marked[stop]) {
+                                is_marked[stop] = 1;
+                                marked.push_back(stop);
+                            }
+                        }
+                    }
+                    if (previous[stop]) {
+                        const Weight boarding = previous[stop]->weight + board_weight_;
+                        if (!on_board || boarding < *on_board) {
+                            on_board = boarding;
+                            board_pos = pos;
+                        }
+                    }
+                    if (on_board && pos + 1 < stops.size()) {
+                        *on_board += segment_weights[pos];
+                    }
+                }
+            }
+
+            for (const VertexId stop : marked) {
+                is_marked[stop] = 0;
+            }
+            if (current[to] && current[to]->round == round) {
+                journeys.push_back(Unpack(labels, round, to));
+            }
+        }
+        return journeys;
+    }
+
+    template <typename Weight>
+    typename RaptorRouter<Weight>::Journey RaptorRouter<Weight>::Unpack(
+        const std::vector<std::vector<std::optional<Label>>>& labels, size_t round, VertexId to) const {
+        Journey journey{ labels[round][to]->weight, {} };
+        for (VertexId stop = to; labels[round][stop]->line != NO_LINE; ) {
+            const Label& label = *labels[round][stop];
+            const auto& segment_weights = lines_[label.line].segment_weights;
+            Weight weight = 0;
+            for (size_t pos = label.board_pos; pos < label.alight_pos; ++pos) {
+                weight += segment_weights[pos];
+            }
+            journey.rides.push_back({ label.line, label.board_pos, label.alight_pos, weight });
+            stop = lines_[label.line].stops[label.board_pos];
+            round = label.round - 1;
+        }
+        std::reverse(journey.rides.begin(), journey.rides.end());
+        return journey;
+    }
+
+}
@@ -1,8 +1,10 @@
 #pragma once
 #include "manager.h"
 #include "json.h"
+#include "utils.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <cassert>
 #include <optional>
@@ -15,6 +17,7 @@
 #include <cstdio>
 #include <memory>
 #include <ctime>
+#include <variant>
 
 using namespace std;
 using namespace Json;
@@ -32,58 +35,66 @@ public:
 	Request(ERequestType type)
 		: Type(type)
 	{}
-
-	virtual void ReadInfo(istream&) = 0;
-	virtual void ReadInfo(const Node&) = 0;
 };
 
-using RequestHolder = unique_ptr<Request>;
-
+// Requests are stored by value in RequestBatch, so there are no virtual
+// methods. Every request has ReadInfo(string_view) for the rest of a text
+// protocol line after the request type and ReadInfo(const ArenaNode&).
 class ModifyRequest : public Request {
 public:
     using Request::Request;
-	virtual void Process(BusManager& manager) const = 0;
 };
 
 class AddStopRequest : public ModifyRequest {
 public:
 	AddStopRequest() : ModifyRequest(Request::ERequestType::ADD_STOP) {}
 
-	void Process(BusManager& manager) const override {
+	AddStopRequest(string name, Location location, unordered_map<string, double> dists_to_stops)
+		: ModifyRequest(Request::ERequestType::ADD_STOP)
+		, StopLocation(location)
+		, Name(move(name))
+		, DistsToStops(move(dists_to_stops))
+	{}
+
+	const string& GetName() const {
+		return Name;
+	}
+
+	Location GetLocation() const {
+		return StopLocation;
+	}
+
+	const unordered_map<string, double>& GetDistances() const {
+		return DistsToStops;
+	}
+
+	void Process(BusManager& manager) const {
 		manager.AddStop(Name, StopLocation, DistsToStops);
 	}
 
-	void ReadInfo(istream& is) override {
-		string input;
-		getline(is, input);
-		auto info = StringUtils::SplitString(input, set<char>{ ':', ',' });
+	void ReadInfo(string_view input) {
+		auto info = StringUtils::SplitString(input, ":,");
 		Name = info[0];
-		stringstream ss;
-		ss << info[1] << " " << info[2];
-		ss >> StopLocation.Latitude >> StopLocation.Longitude;
+		StopLocation.Latitude = StringUtils::ParseNumber<double>(info[1]);
+		StopLocation.Longitude = StringUtils::ParseNumber<double>(info[2]);
 		for (size_t i = 3; i < info.size(); ++i) {
+			// "3900m to Stop name"
 			auto pos = info[i].find('m');
-			assert(pos != string::npos);
-			info[i].insert(info[i].begin() + pos, ' ');
-			stringstream ss;
-			ss << info[i];
-			double dist;
-			string trash;
-			string stop_name;
-			ss >> dist >> trash >> trash;
-			getline(ss, stop_name);
-			stop_name = StringUtils::SplitString(stop_name)[0];
-			DistsToStops[stop_name] = dist;
+			assert(pos != string_view::npos);
+			double dist = StringUtils::ParseNumber<double>(info[i].substr(0, pos));
+			auto stop_name = StringUtils::Trim(info[i].substr(pos + 1));
+			assert(stop_name.substr(0, 2) == "to");
+			DistsToStops[string(StringUtils::Trim(stop_name.substr(2)))] = dist;
 		}
 	}
 
-	void ReadInfo(const Node& node) override {
+	void ReadInfo(const ArenaNode& node) {
 		const auto& node_map = node.AsMap();
 		StopLocation = { node_map.at("latitude").AsDouble(), node_map.at("longitude").AsDouble() };
 		Name = node_map.at("name").AsString();
 		if (node_map.count("road_distances")) {
 			for (const auto& [stop_name, dist] : node_map.at("road_distances").AsMap()) {
-				DistsToStops[stop_name] = dist.AsDouble();
+				DistsToStops[string(stop_name)] = dist.AsDouble();
 			}
 		}
 	}
@@ -98,29 +109,46 @@ class AddBusRequest : public ModifyRequest {
 public:
 	AddBusRequest() : ModifyRequest(Request::ERequestType::ADD_BUS) {}
 
-	void Process(BusManager& manager) const override {
+	// stops of the whole route, the way back included
+	AddBusRequest(string name, vector<string> stops)
+		: ModifyRequest(Request::ERequestType::ADD_BUS)
+		, BusStopNames(move(stops))
+		, Name(move(name))
+	{}
+
+	const string& GetName() const {
+		return Name;
+	}
+
+	const vector<string>& GetStops() const {
+		return BusStopNames;
+	}
+
+	void Process(BusManager& manager) const {
 		manager.AddBus(Name, BusStopNames);
 	}
 
-	void ReadInfo(istream& is) override {
-		string input;
-		getline(is, input);
-		bool is_cycle = (input.find('>') != string::npos);
+	void ReadInfo(string_view input) {
+		bool is_cycle = (input.find('>') != string_view::npos);
 
-		auto info = StringUtils::SplitString(input, set<char>{ '-', '>', ':' });
+		auto info = StringUtils::SplitString(input, "->:");
 		Name = info[0];
-		copy(info.begin() + 1, info.end(), back_inserter(BusStopNames));
+		for (auto it = info.begin() + 1; it != info.end(); ++it) {
+			BusStopNames.emplace_back(*it);
+		}
 		if (!is_cycle) {
-			copy(info.rbegin() + 1, info.rend() - 1, back_inserter(BusStopNames));
+			for (auto it = info.rbegin() + 1; it < info.rend() - 1; ++it) {
+				BusStopNames.emplace_back(*it);
+			}
 		}
 	}
 
-	void ReadInfo(const Node& node) override {
+	void ReadInfo(const ArenaNode& node) {
 		const auto& node_map = node.AsMap();
 		Name = node_map.at("name").AsString();
 		const auto& stop_nodes = node_map.at("stops").AsArray();
 		for (const auto& stop_node : stop_nodes) {
-			BusStopNames.push_back(stop_node.AsString());
+			BusStopNames.emplace_back(stop_node.AsString());
 		}
 		if (node_map.at("is_roundtrip").AsDouble() < 0.5) { // false
 			vector<string> reversed_path{ next(BusStopNames.rbegin()), BusStopNames.rend() };
@@ -136,35 +164,38 @@ private:
 	string Name;
 };
 
-template <typename ResultType>
 class ReadRequest : public Request {
 public:
     using Request::Request;
-	virtual ResultType Process(BusManager& manager) const = 0;
+
+	int32_t GetRequestId() const {
+		return Request_id;
+	}
 
 protected:
 	int32_t Request_id = -1;
 };
 
-class ReadBusInfoRequest : public ReadRequest<BusInfoResponse> {
+class ReadBusInfoRequest : public ReadRequest {
 public:
 	ReadBusInfoRequest() : ReadRequest(Request::ERequestType::QUERY_BUS) {}
 
-	BusInfoResponse Process(BusManager& manager) const override {
+	BusInfoResponse Process(BusManager& manager) const {
 		auto response = manager.GetBusInfoResponse(BusName);
 		response.SetRequestId(Request_id);
 		return response;
 	}
 
-	void ReadInfo(istream& is) override {
-		string input;
-		getline(is, input);
-		auto info = StringUtils::SplitString(input);
-		assert(info.size() == 1);
-		BusName = info[0];
+	// requests with equal keys have equal answers
+	string GetKey() const {
+		return "B"s + BusName;
 	}
 
-	void ReadInfo(const Node& node) override {
+	void ReadInfo(string_view input) {
+		BusName = StringUtils::Trim(input);
+	}
+
+	void ReadInfo(const ArenaNode& node) {
 		BusName = node.AsMap().at("name").AsString();
 		Request_id = static_cast<int>(node.AsMap().at("id").AsDouble());
 	}
@@ -173,25 +204,25 @@ private:
 	string BusName;
 };
 
-class ReadStopInfoRequest : public ReadRequest<StopInfoResponse> {
+class ReadStopInfoRequest : public ReadRequest {
 public:
 	ReadStopInfoRequest() : ReadRequest(Request::ERequestType::QUERY_STOP) {}
 
-	StopInfoResponse Process(BusManager& manager) const override {
+	StopInfoResponse Process(BusManager& manager) const {
 		auto response = manager.GetStopInfoResponse(StopName);
 		response.SetRequestId(Request_id);
 		return response;
 	}
 
-	void ReadInfo(istream& is) override {
-		string input;
-		getline(is, input);
-		auto info = StringUtils::SplitString(input);
-		assert(info.size() == 1);
-		StopName = info[0];
+	string GetKey() const {
+		return "S"s + StopName;
 	}
 
-	void ReadInfo(const Node& node) override {
+	void ReadInfo(string_view input) {
+		StopName = StringUtils::Trim(input);
+	}
+
+	void ReadInfo(const ArenaNode& node) {
 		StopName = node.AsMap().at("name").AsString();
 		Request_id = static_cast<int>(node.AsMap().at("id").AsDouble());
 	}
@@ -200,28 +231,68 @@ private:
 	string StopName;
 };
 
-class ReadRouteInfoRequest : public ReadRequest<RouteInfoResponse> {
+const unordered_map<string_view, ERouteMode> RouteModeByString = {
+	{"fastest", ERouteMode::FASTEST},
+	{"min_transfers", ERouteMode::MIN_TRANSFERS},
+	{"pareto", ERouteMode::PARETO}
+};
+
+class ReadRouteInfoRequest : public ReadRequest {
 public:
 	ReadRouteInfoRequest() : ReadRequest(Request::ERequestType::QUERY_ROUTE) {}
 
-	RouteInfoResponse Process(BusManager& manager) const override {
-		auto response = manager.GetRouteResponse(StopFrom, StopTo);
-		response.Info.AddNodeToMap("request_id", Node(static_cast<double>(Request_id)));
+	RouteInfoResponse Process(BusManager& manager) const {
+		auto response = manager.GetRouteResponse(StopFrom, StopTo, Mode, RouteCount);
 		response.SetRequestId(Request_id);
 		return response;
 	}
 
-	void ReadInfo(istream& is) override {
+	string GetKey() const {
+		string key = "R"s + StopFrom;
+		key += '\0';
+		key += StopTo;
+		key += '\0';
+		key += to_string(static_cast<int>(Mode));
+		key += '\0';
+		key += to_string(RouteCount);
+		return key;
+	}
+
+	void ReadInfo(string_view) {
 		throw runtime_error("Not implemented");
 	}
 
-	void ReadInfo(const Node& node) override {
+	void ReadInfo(const ArenaNode& node) {
 		StopFrom = node.AsMap().at("from").AsString();
 		StopTo = node.AsMap().at("to").AsString();
 		Request_id = static_cast<int>(node.AsMap().at("id").AsDouble());
+		if (node.AsMap().count("mode")) {
+			Mode = RouteModeByString.at(node.AsMap().at("mode").AsString());
+		}
+		if (node.AsMap().count("k")) {
+			const double route_count = node.AsMap().at("k").AsDouble();
+			if (!(route_count >= 1) || route_count != floor(route_count)) {
+				throw invalid_argument("k must be a positive integer");
+			}
+			RouteCount = static_cast<size_t>(min(route_count, static_cast<double>(MAX_ROUTE_COUNT)));
+		}
 	}
 
 private:
 	string StopFrom;
 	string StopTo;
+	ERouteMode Mode = ERouteMode::FASTEST;
+	size_t RouteCount = 1;
+};
+
+
+using StatRequest = variant<ReadBusInfoRequest, ReadStopInfoRequest, ReadRouteInfoRequest>;
+
+// All requests of one input, one contiguous array per kind.
+// Stats keep the input order, since responses are printed in it.
+struct RequestBatch {
+	vector<AddStopRequest> AddStops;
+	vector<AddBusRequest> AddBuses;
+	vector<StatRequest> Stats;
+	bool HasRouteQueries = false;
 };
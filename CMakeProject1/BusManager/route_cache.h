@@ -0,0 +1,100 @@
+#pragma once
+
+#include "graph.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+// Route answer printed once without its request_id: the text before the
+// request_id value and the text after it
+struct SerializedRoute {
+	string BeforeRequestId;
+	string AfterRequestId;
+};
+
+using SerializedRoutePtr = shared_ptr<const SerializedRoute>;
+
+// Bounded LRU cache of serialized route answers keyed by (from, to) stop ids
+// and the route options.
+// Safe to use from several threads.
+class RouteCache {
+public:
+	struct Stats {
+		size_t Hits = 0;
+		size_t Misses = 0;
+	};
+
+	explicit RouteCache(size_t capacity)
+		: Capacity(capacity)
+	{}
+
+	// the same stops queried in different route modes give different answers
+	struct Key {
+		Graph::VertexId From;
+		Graph::VertexId To;
+		uint32_t Mode = 0;
+		size_t RouteCount = 1;
+
+		bool operator==(const Key& other) const {
+			return From == other.From && To == other.To && Mode == other.Mode && RouteCount == other.RouteCount;
+		}
+	};
+
+	SerializedRoutePtr Get(const Key& key, const function<SerializedRoutePtr()>& build) {
+		if (Capacity == 0) {
+			++Misses;
+			return build();
+		}
+
+		{
+			lock_guard lock(Mutex);
+			auto it = Positions.find(key);
+			if (it != Positions.end()) {
+				Entries.splice(Entries.begin(), Entries, it->second);
+				++Hits;
+				return it->second->second;
+			}
+		}
+
+		++Misses;
+		auto value = build();
+		lock_guard lock(Mutex);
+		if (!Positions.count(key)) {
+			Entries.emplace_front(key, value);
+			Positions[key] = Entries.begin();
+			if (Entries.size() > Capacity) {
+				Positions.erase(Entries.back().first);
+				Entries.pop_back();
+			}
+		}
+		return value;
+	}
+
+	Stats GetStats() const {
+		return { Hits.load(), Misses.load() };
+	}
+
+private:
+	struct KeyHasher {
+		size_t operator()(const Key& key) const {
+			return ((key.From * 1'000'003 + key.To) * 4 + key.Mode) * 31 + key.RouteCount;
+		}
+	};
+
+	size_t Capacity;
+	list<pair<Key, SerializedRoutePtr>> Entries;
+	unordered_map<Key, list<pair<Key, SerializedRoutePtr>>::iterator, KeyHasher> Positions;
+	mutex Mutex;
+	atomic<size_t> Hits = 0;
+	atomic<size_t> Misses = 0;
+};
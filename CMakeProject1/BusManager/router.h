@@ -6,21 +6,22 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <optional>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <variant>
 #include <vector>
 
 namespace Graph {
 
+    // Common interface of the routers: a route is built once, its edges are
+    // read by index and the route is released when it is no longer needed
     template <typename Weight>
-    class Router {
-    private:
-        using Graph = DirectedWeightedGraph<Weight>;
-
+    class IRouter {
     public:
-        Router(const Graph& graph);
-
         using RouteId = uint64_t;
 
         struct RouteInfo {
@@ -29,110 +30,169 @@ namespace Graph {
             size_t edge_count;
         };
 
-        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        virtual ~IRouter() = default;
+
+        virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
         EdgeId GetRouteEdge(RouteId route_id, size_t edge_idx) const;
         void ReleaseRoute(RouteId route_id);
 
-    private:
-        const Graph& graph_;
-
-        struct RouteInternalData {
-            Weight weight;
-            std::optional<EdgeId> prev_edge;
-        };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    protected:
+        RouteInfo SaveRoute(Weight weight, std::vector<EdgeId>&& edges) const;
 
+    private:
         using ExpandedRoute = std::vector<EdgeId>;
+        // guards the expanded routes, so routes can be built from several threads
+        mutable std::mutex expanded_routes_mutex_;
         mutable RouteId next_route_id_ = 0;
         mutable std::unordered_map<RouteId, ExpandedRoute> expanded_routes_cache_;
+    };
 
-        void InitializeRoutesInternalData(const Graph& graph) {
-            const size_t vertex_count = graph.GetVertexCount();
-            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ 0, std::nullopt };
-                for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                    const auto& edge = graph.GetEdge(edge_id);
-                    assert(edge.weight >= 0);
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                        route_internal_data = RouteInternalData{ edge.weight, edge_id };
-                    }
-                }
-            }
-        }
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to,
-            const RouteInternalData& route_from, const RouteInternalData& route_to) {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-                route_relaxing = {
-                    candidate_weight,
-                    route_to.prev_edge
-                        ? route_to.prev_edge
-                        : route_from.prev_edge
-                };
-            }
-        }
+    template <typename Weight>
+    typename IRouter<Weight>::RouteInfo IRouter<Weight>::SaveRoute(Weight weight, std::vector<EdgeId>&& edges) const {
+        std::lock_guard lock(expanded_routes_mutex_);
+        const RouteId route_id = next_route_id_++;
+        const size_t route_edge_count = edges.size();
+        expanded_routes_cache_[route_id] = std::move(edges);
+        return RouteInfo{ route_id, weight, route_edge_count };
+    }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                        }
-                    }
-                }
-            }
-        }
+    template <typename Weight>
+    EdgeId IRouter<Weight>::GetRouteEdge(RouteId route_id, size_t edge_idx) const {
+        std::lock_guard lock(expanded_routes_mutex_);
+        return expanded_routes_cache_.at(route_id)[edge_idx];
+    }
+
+    template <typename Weight>
+    void IRouter<Weight>::ReleaseRoute(RouteId route_id) {
+        std::lock_guard lock(expanded_routes_mutex_);
+        expanded_routes_cache_.erase(route_id);
+    }
+
+
+    // All pairs shortest paths precomputed by Floyd-Warshall, V x V memory.
+    // Weights and the last edges of the routes are kept in separate flat
+    // matrices: the edges take 16 bits while the edge ids fit and 32 bits
+    // otherwise, so the route unpacking reads only them. StoredWeight = float
+    // halves the weight matrix, route weights are then summed from the edges.
+    template <typename Weight, typename StoredWeight = Weight>
+    class Router : public IRouter<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        Router(const Graph& graph);
+
+        using typename IRouter<Weight>::RouteInfo;
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    private:
+        static_assert(std::numeric_limits<StoredWeight>::has_infinity);
+        static constexpr StoredWeight NO_ROUTE = std::numeric_limits<StoredWeight>::infinity();
 
-        RoutesInternalData routes_internal_data_;
+        template <typename Index>
+        static constexpr Index NO_EDGE = std::numeric_limits<Index>::max();
+
+        template <typename Index>
+        void ComputeRoutes(std::vector<Index>& prev_edges);
+
+        template <typename Index>
+        std::vector<EdgeId> ExpandRoute(const std::vector<Index>& prev_edges, VertexId from, VertexId to) const;
+
+        const Graph& graph_;
+        const size_t vertex_count_;
+        // [from * vertex_count_ + to]
+        std::vector<StoredWeight> weights_;
+        std::variant<std::vector<uint16_t>, std::vector<uint32_t>> prev_edges_;
     };
 
 
-    template <typename Weight>
-    Router<Weight>::Router(const Graph& graph)
+    template <typename Weight, typename StoredWeight>
+    Router<Weight, StoredWeight>::Router(const Graph& graph)
         : graph_(graph),
-        routes_internal_data_(graph.GetVertexCount(), std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+        vertex_count_(graph.GetVertexCount()),
+        weights_(vertex_count_ * vertex_count_, NO_ROUTE)
     {
-        InitializeRoutesInternalData(graph);
-
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        if (graph.GetEdgeCount() < NO_EDGE<uint16_t>) {
+            prev_edges_ = std::vector<uint16_t>(vertex_count_ * vertex_count_, NO_EDGE<uint16_t>);
+        }
+        else {
+            prev_edges_ = std::vector<uint32_t>(vertex_count_ * vertex_count_, NO_EDGE<uint32_t>);
         }
+        std::visit([this](auto& prev_edges) { ComputeRoutes(prev_edges); }, prev_edges_);
     }
 
-    template <typename Weight>
-    std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from, VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_[from][to];
-        if (!route_internal_data) {
-            return std::nullopt;
-        }
-        const Weight weight = route_internal_data->weight;
-        std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
-            edges.push_back(*edge_id);
+    template <typename Weight, typename StoredWeight>
+    template <typename Index>
+    void Router<Weight, StoredWeight>::ComputeRoutes(std::vector<Index>& prev_edges) {
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            weights_[vertex * vertex_count_ + vertex] = 0;
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                assert(edge.weight >= 0);
+                const size_t idx = vertex * vertex_count_ + edge.to;
+                const auto weight = static_cast<StoredWeight>(edge.weight);
+                if (weights_[idx] == NO_ROUTE || weights_[idx] > weight) {
+                    weights_[idx] = weight;
+                    prev_edges[idx] = static_cast<Index>(edge_id);
+                }
+            }
         }
-        std::reverse(std::begin(edges), std::end(edges));
 
-        const RouteId route_id = next_route_id_++;
-        const size_t route_edge_count = edges.size();
-        expanded_routes_cache_[route_id] = std::move(edges);
-        return RouteInfo{ route_id, weight, route_edge_count };
+        for (VertexId vertex_through = 0; vertex_through < vertex_count_; ++vertex_through) {
+            const StoredWeight* through_row = &weights_[vertex_through * vertex_count_];
+            const Index* through_edges = &prev_edges[vertex_through * vertex_count_];
+            for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+                const size_t from_row = vertex_from * vertex_count_;
+                const StoredWeight weight_from = weights_[from_row + vertex_through];
+                if (weight_from == NO_ROUTE) {
+                    continue;
+                }
+                const Index edge_from = prev_edges[from_row + vertex_through];
+                for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+                    if (through_row[vertex_to] == NO_ROUTE) {
+                        continue;
+                    }
+                    const StoredWeight candidate_weight = weight_from + through_row[vertex_to];
+                    if (candidate_weight < weights_[from_row + vertex_to]) {
+                        weights_[from_row + vertex_to] = candidate_weight;
+                        prev_edges[from_row + vertex_to] = through_edges[vertex_to] != NO_EDGE<Index>
+                            ? through_edges[vertex_to]
+                            : edge_from;
+                    }
+                }
+            }
+        }
     }
 
-    template <typename Weight>
-    EdgeId Router<Weight>::GetRouteEdge(RouteId route_id, size_t edge_idx) const {
-        return expanded_routes_cache_.at(route_id)[edge_idx];
+    template <typename Weight, typename StoredWeight>
+    template <typename Index>
+    std::vector<EdgeId> Router<Weight, StoredWeight>::ExpandRoute(const std::vector<Index>& prev_edges,
+        VertexId from, VertexId to) const {
+        std::vector<EdgeId> edges;
+        const Index* from_edges = &prev_edges[from * vertex_count_];
+        for (Index edge_id = from_edges[to]; edge_id != NO_EDGE<Index>; edge_id = from_edges[graph_.GetEdge(edge_id).from]) {
+            edges.push_back(edge_id);
+        }
+        std::reverse(std::begin(edges), std::end(edges));
+        return edges;
     }
 
-    template <typename Weight>
-    void Router<Weight>::ReleaseRoute(RouteId route_id) {
-        expanded_routes_cache_.erase(route_id);
+    template <typename Weight, typename StoredWeight>
+    std::optional<typename Router<Weight, StoredWeight>::RouteInfo> Router<Weight, StoredWeight>::BuildRoute(VertexId from, VertexId to) const {
+        if (weights_[from * vertex_count_ + to] == NO_ROUTE) {
+            return std::nullopt;
+        }
+        auto edges = std::visit([&](const auto& prev_edges) { return ExpandRoute(prev_edges, from, to); }, prev_edges_);
+        Weight weight = weights_[from * vertex_count_ + to];
+        if constexpr (!std::is_same_v<Weight, StoredWeight>) {
+            weight = 0;
+            for (const EdgeId edge_id : edges) {
+                weight += graph_.GetEdge(edge_id).weight;
+            }
+        }
+        return this->SaveRoute(weight, std::move(edges));
     }
 
 }
@@ -1,43 +1,58 @@
 #pragma once
 
+#include <charconv>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
 
 namespace StringUtils {
 
-	void Trim(string& s) {
-		while (!s.empty() && (s.back() == ' ' || s.back() == '\n')) {
-			s.pop_back();
+	inline string_view Trim(string_view s) {
+		const string_view spaces = " \n\r";
+		size_t first = s.find_first_not_of(spaces);
+		if (first == string_view::npos) {
+			return {};
 		}
-		reverse(s.begin(), s.end());
-		while (!s.empty() && (s.back() == ' ' || s.back() == '\n')) {
-			s.pop_back();
-		}
-		reverse(s.begin(), s.end());
+		return s.substr(first, s.find_last_not_of(spaces) - first + 1);
 	}
 
-	vector<string> SplitString(string& s, set<char>&& delims = {}) {
-		vector<string> ret;
-		string cur = "";
-		for (auto ch : s) {
-			if (delims.count(ch)) {
-				Trim(cur);
-				if (!cur.empty()) {
-					ret.push_back(cur);
-				}
-				cur = "";
+	// Splits by any of delims; tokens are trimmed, empty ones are dropped
+	inline vector<string_view> SplitString(string_view s, string_view delims = {}) {
+		vector<string_view> ret;
+		while (true) {
+			size_t pos = s.find_first_of(delims);
+			auto token = Trim(s.substr(0, pos));
+			if (!token.empty()) {
+				ret.push_back(token);
 			}
-			else {
-				cur += ch;
+			if (pos == string_view::npos) {
+				break;
 			}
-		}
-		Trim(cur);
-		if (!cur.empty()) {
-			ret.push_back(cur);
+			s.remove_prefix(pos + 1);
 		}
 		return ret;
 	}
 
+	// Cuts the first line off the text, without the line break
+	inline string_view ReadLine(string_view& text) {
+		size_t pos = text.find('\n');
+		auto line = text.substr(0, pos);
+		text.remove_prefix(pos == string_view::npos ? text.size() : pos + 1);
+		return line;
+	}
+
+	template <typename Number>
+	Number ParseNumber(string_view s) {
+		s = Trim(s);
+		Number result = 0;
+		auto [ptr, ec] = from_chars(s.data(), s.data() + s.size(), result);
+		if (ec != errc() || ptr != s.data() + s.size()) {
+			throw invalid_argument("not a number: " + string(s));
+		}
+		return result;
+	}
+
 }
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+// ,    Wake   . ,
+//    ,     .
+class BackgroundEvictor {
+public:
+    explicit BackgroundEvictor(function<void()> evict)
+        : evict(move(evict))
+        , thread_([this] { Work(); })
+    {}
+
+    BackgroundEvictor(const BackgroundEvictor&) = delete;
+    BackgroundEvictor& operator=(const BackgroundEvictor&) = delete;
+
+    ~BackgroundEvictor() {
+        {
+            lock_guard lock(mutex_);
+            stopped = true;
+        }
+        woken.notify_one();
+        thread_.join();
+    }
+
+    //     :  
+    //    mutex_
+    void Wake() {
+        {
+            lock_guard lock(mutex_);
+            if (requested) {
+                return;
+            }
+            requested = true;
+        }
+        woken.notify_one();
+    }
+
+private:
+    void Work() {
+        while (true) {
+            {
+                unique_lock lock(mutex_);
+                woken.wait(lock, [this] { return stopped || requested; });
+                if (stopped) {
+                    return;
+                }
+                requested = false;
+            }
+            evict();
+        }
+    }
+
+    function<void()> evict;
+    bool requested = false;
+    bool stopped = false;
+    mutex mutex_;
+    condition_variable woken;
+    //  ,     
+    thread thread_;
+};
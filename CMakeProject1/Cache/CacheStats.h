@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+//  .    ,    
+//   ,      .
+class CacheStatistics {
+public:
+    void AddHit() {
+        hits.fetch_add(1, memory_order_relaxed);
+    }
+
+    void AddMiss() {
+        misses.fetch_add(1, memory_order_relaxed);
+    }
+
+    void AddEvictions(size_t count) {
+        evictions.fetch_add(count, memory_order_relaxed);
+    }
+
+    void AddRejection() {
+        rejections.fetch_add(1, memory_order_relaxed);
+    }
+
+    void AddDiskHit() {
+        disk_hits.fetch_add(1, memory_order_relaxed);
+    }
+
+    void AddUsedMemory(size_t bytes) {
+        used_memory.fetch_add(bytes, memory_order_relaxed);
+    }
+
+    void RemoveUsedMemory(size_t bytes) {
+        used_memory.fetch_sub(bytes, memory_order_relaxed);
+    }
+
+    void AddUnpack(chrono::steady_clock::duration duration) {
+        const auto microseconds = chrono::duration_cast<chrono::microseconds>(duration).count();
+        //  i    [2^(i-1), 2^i) 
+        const size_t bucket = bit_width(static_cast<uint64_t>(max<decltype(microseconds)>(microseconds, 0)));
+        unpack_latency[min(bucket, unpack_latency.size() - 1)].fetch_add(1, memory_order_relaxed);
+        unpacks.fetch_add(1, memory_order_relaxed);
+    }
+
+    ICache::Stats GetSnapshot() const {
+        ICache::Stats stats;
+        stats.hits = hits.load(memory_order_relaxed);
+        stats.misses = misses.load(memory_order_relaxed);
+        stats.unpacks = unpacks.load(memory_order_relaxed);
+        stats.evictions = evictions.load(memory_order_relaxed);
+        stats.rejections = rejections.load(memory_order_relaxed);
+        stats.disk_hits = disk_hits.load(memory_order_relaxed);
+        stats.used_memory = used_memory.load(memory_order_relaxed);
+        for (size_t i = 0; i < unpack_latency.size(); ++i) {
+            stats.unpack_latency_buckets[i] = unpack_latency[i].load(memory_order_relaxed);
+        }
+        return stats;
+    }
+
+private:
+    atomic<size_t> hits = 0;
+    atomic<size_t> misses = 0;
+    atomic<size_t> unpacks = 0;
+    atomic<size_t> evictions = 0;
+    atomic<size_t> rejections = 0;
+    atomic<size_t> disk_hits = 0;
+    atomic<size_t> used_memory = 0;
+    array<atomic<size_t>, ICache::Stats::LATENCY_BUCKET_COUNT> unpack_latency = {};
+};
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <string>
+#include <vector>
 
 // ,  
 class IBook {
@@ -28,15 +30,99 @@ public:
 // ,  
 class ICache {
 public:
+    //     
+    enum class EvictionPolicy {
+        //    
+        LRU,
+        // LRU-   LRU     
+        W_TINY_LFU,
+        //    FIFO-  -
+        S3_FIFO,
+        //  ,     , 
+        //     ,     
+        GDSF
+    };
+
     //  
     struct Settings {
         //    ,  
         // ,  
         size_t max_memory = 0;
+
+        //     .  
+        //     ,     
+        // max_memory    .
+        size_t shard_count = 1;
+
+        EvictionPolicy eviction_policy = EvictionPolicy::LRU;
+
+        //   ,    Prefetch.
+        //      Prefetch.
+        size_t prefetch_threads = 1;
+
+        //    :    
+        //          
+        // .     max_disk_memory 
+        //  .
+        std::string disk_directory;
+        //     ,  
+        size_t max_disk_memory = 0;
+
+        //   max_memory    ,    ,
+        //  ,  -    
+        // ( , -,  ). 
+        //    .
+        bool account_overhead = false;
+
+        //   max_memory,  GetBook   ,  
+        //    hard_memory_limit.  max_memory
+        //   ,     90% max_memory.
+        size_t hard_memory_limit = 0;
     };
 
     using BookPtr = std::shared_ptr<const IBook>;
 
+    //   
+    struct Stats {
+        static constexpr size_t LATENCY_BUCKET_COUNT = 32;
+
+        //  GetBook,     
+        size_t hits = 0;
+        size_t misses = 0;
+        //  UnpackBook,  
+        size_t unpacks = 0;
+        size_t evictions = 0;
+        // ,       
+        size_t rejections = 0;
+        // ,     
+        size_t disk_hits = 0;
+        //  ,   ,    ,
+        //   account_overhead
+        size_t used_memory = 0;
+        //     
+        size_t disk_used_memory = 0;
+        // unpack_latency_buckets[i] -   
+        //  2^(i-1)  2^i ,    -  
+        std::array<size_t, LATENCY_BUCKET_COUNT> unpack_latency_buckets = {};
+
+        //       quantile ,
+        //  
+        size_t GetUnpackLatencyQuantile(double quantile) const {
+            size_t total = 0;
+            for (size_t count : unpack_latency_buckets) {
+                total += count;
+            }
+            size_t seen = 0;
+            for (size_t i = 0; i < LATENCY_BUCKET_COUNT; ++i) {
+                seen += unpack_latency_buckets[i];
+                if (seen > 0 && seen >= quantile * total) {
+                    return size_t(1) << i;
+                }
+            }
+            return 0;
+        }
+    };
+
 public:
     virtual ~ICache() = default;
 
@@ -45,8 +131,19 @@ public:
     //          
     // max_memory.      ,    
     //  .       max_memory,  
-    //  .
+    //  .  GDSF     ,  
+    //   .
     virtual BookPtr GetBook(const std::string& book_name) = 0;
+
+    //   ,        
+    // ,   .  GetBook   
+    //    ,    .
+    virtual void Prefetch(const std::vector<std::string>&) {}
+
+    //    
+    virtual Stats GetStats() const {
+        return {};
+    }
 };
 
 //         
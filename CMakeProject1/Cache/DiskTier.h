@@ -0,0 +1,177 @@
+#pragma once
+
+#include "Common.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ,      
+class StoredBook : public IBook {
+public:
+    StoredBook(string name, string content)
+        : name(move(name))
+        , content(move(content))
+    {}
+
+    const string& GetName() const override {
+        return name;
+    }
+
+    const string& GetContent() const override {
+        return content;
+    }
+
+private:
+    string name;
+    string content;
+};
+
+//   : ,   ,  
+//    .        
+// LRU-. ,   ,   , 
+//          .
+//      :   
+//     .
+class DiskTier {
+public:
+    DiskTier(filesystem::path directory, size_t max_bytes)
+        : directory(move(directory))
+        , max_bytes(max_bytes)
+    {
+        filesystem::create_directories(this->directory);
+    }
+
+    DiskTier(const DiskTier&) = delete;
+    DiskTier& operator=(const DiskTier&) = delete;
+
+    ~DiskTier() {
+        for (const auto& [book_name, file] : files) {
+            RemoveFile(file.id);
+        }
+    }
+
+    //  nullptr,          .
+    //  unpack_cost   ,    .
+    ICache::BookPtr Get(const string& book_name, double& unpack_cost) {
+        uint64_t id = 0;
+        size_t size = 0;
+        {
+            lock_guard lock(mutex_);
+            auto it = files.find(book_name);
+            if (it == files.end()) {
+                return nullptr;
+            }
+            order.splice(order.begin(), order, it->second.position);
+            id = it->second.id;
+            size = it->second.size;
+            unpack_cost = it->second.unpack_cost;
+        }
+
+        //    :       
+        //  ,       
+        ifstream input(GetPath(id), ios::binary | ios::ate);
+        if (!input || static_cast<size_t>(input.tellg()) != size) {
+            return nullptr;
+        }
+        string content(size, '\0');
+        input.seekg(0);
+        if (!input.read(content.data(), size)) {
+            return nullptr;
+        }
+        return make_shared<StoredBook>(book_name, move(content));
+    }
+
+    //  ,      ,    .
+    //      :    .
+    void Put(const IBook& book, double unpack_cost) {
+        const string& content = book.GetContent();
+        if (content.size() > max_bytes) {
+            return;
+        }
+
+        uint64_t id = 0;
+        vector<uint64_t> evicted_ids;
+        {
+            lock_guard lock(mutex_);
+            auto [it, inserted] = files.try_emplace(book.GetName());
+            if (!inserted) {
+                order.splice(order.begin(), order, it->second.position);
+                return;
+            }
+            id = next_id++;
+            order.push_front(book.GetName());
+            it->second = { id, content.size(), unpack_cost, order.begin() };
+            used_bytes += content.size();
+            while (used_bytes > max_bytes) {
+                auto victim = files.find(order.back());
+                evicted_ids.push_back(victim->second.id);
+                Erase(victim);
+            }
+        }
+
+        for (uint64_t evicted_id : evicted_ids) {
+            RemoveFile(evicted_id);
+        }
+        ofstream output(GetPath(id), ios::binary | ios::trunc);
+        output.write(content.data(), content.size());
+        output.close();
+        if (!output) {
+            {
+                lock_guard lock(mutex_);
+                auto it = files.find(book.GetName());
+                if (it != files.end() && it->second.id == id) {
+                    Erase(it);
+                }
+            }
+            RemoveFile(id);
+        }
+    }
+
+    size_t GetUsedBytes() const {
+        lock_guard lock(mutex_);
+        return used_bytes;
+    }
+
+private:
+    struct File {
+        uint64_t id = 0;
+        size_t size = 0;
+        //     ,   
+        //        
+        double unpack_cost = 1;
+        list<string>::iterator position;
+    };
+
+    filesystem::path GetPath(uint64_t id) const {
+        return directory / (to_string(id) + ".book");
+    }
+
+    void RemoveFile(uint64_t id) const {
+        error_code error;
+        filesystem::remove(GetPath(id), error);
+    }
+
+    void Erase(unordered_map<string, File>::iterator it) {
+        used_bytes -= it->second.size;
+        order.erase(it->second.position);
+        files.erase(it);
+    }
+
+    filesystem::path directory;
+    size_t max_bytes;
+    unordered_map<string, File> files;
+    //       
+    list<string> order;
+    size_t used_bytes = 0;
+    uint64_t next_id = 0;
+    mutable mutex mutex_;
+};
@@ -0,0 +1,483 @@
+#pragma once
+
+#include "Common.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//   .      
+//           .
+struct CacheEntry {
+    ICache::BookPtr book;
+    size_t size = 0;
+    size_t name_hash = 0;
+    //     ,   
+    double cost = 1;
+    double priority = 0;
+    CacheEntry* prev = nullptr;
+    CacheEntry* next = nullptr;
+    uint8_t queue = 0;
+    uint8_t frequency = 0;
+};
+
+//         .
+//     ,   .
+class EntryList {
+public:
+    EntryList() {
+        head.prev = &head;
+        head.next = &head;
+    }
+
+    EntryList(const EntryList&) = delete;
+    EntryList& operator=(const EntryList&) = delete;
+
+    bool Empty() const {
+        return head.next == &head;
+    }
+
+    CacheEntry& Back() {
+        return *head.prev;
+    }
+
+    size_t GetBytes() const {
+        return bytes;
+    }
+
+    void PushFront(CacheEntry& entry) {
+        entry.prev = &head;
+        entry.next = head.next;
+        head.next->prev = &entry;
+        head.next = &entry;
+        bytes += entry.size;
+    }
+
+    void Unlink(CacheEntry& entry) {
+        entry.prev->next = entry.next;
+        entry.next->prev = entry.prev;
+        bytes -= entry.size;
+    }
+
+    void Clear() {
+        head.prev = &head;
+        head.next = &head;
+        bytes = 0;
+    }
+
+private:
+    CacheEntry head;
+    size_t bytes = 0;
+};
+
+// ,    .    
+//   ,    .
+class IEvictionPolicy {
+public:
+    virtual ~IEvictionPolicy() = default;
+
+    // ,      ,    
+    //  bytes_to_free .   
+    //  ,     .
+    virtual bool Admit(const CacheEntry&, size_t) {
+        return true;
+    }
+
+    //  ,   
+    virtual void Insert(CacheEntry& entry) = 0;
+
+    //   ,     
+    virtual void Touch(CacheEntry& entry) = 0;
+
+    //      ,   .
+    // ,      .
+    virtual CacheEntry& Evict() = 0;
+
+    //    
+    virtual void Clear() = 0;
+
+    //       : ,
+    //      
+    virtual size_t GetOverhead() const {
+        return 0;
+    }
+};
+
+class LruPolicy : public IEvictionPolicy {
+public:
+    void Insert(CacheEntry& entry) override {
+        entries.PushFront(entry);
+    }
+
+    void Touch(CacheEntry& entry) override {
+        entries.Unlink(entry);
+        entries.PushFront(entry);
+    }
+
+    CacheEntry& Evict() override {
+        CacheEntry& oldest = entries.Back();
+        entries.Unlink(oldest);
+        return oldest;
+    }
+
+    void Clear() override {
+        entries.Clear();
+    }
+
+private:
+    EntryList entries;
+};
+
+//   : count-min sketch   
+// 8- .       ,
+//    ,    .
+class FrequencySketch {
+public:
+    explicit FrequencySketch(size_t width_log = 12)
+        : width_mask((size_t(1) << width_log) - 1)
+        , reset_period(10 << width_log)
+    {
+        for (auto& row : rows) {
+            row.assign(width_mask + 1, 0);
+        }
+    }
+
+    void Add(size_t hash) {
+        for (size_t i = 0; i < rows.size(); ++i) {
+            auto& counter = rows[i][Index(hash, i)];
+            if (counter < UINT8_MAX) {
+                ++counter;
+            }
+        }
+        if (++additions == reset_period) {
+            for (auto& row : rows) {
+                for (auto& counter : row) {
+                    counter /= 2;
+                }
+            }
+            additions /= 2;
+        }
+    }
+
+    size_t GetMemory() const {
+        return rows.size() * (width_mask + 1) * sizeof(uint8_t);
+    }
+
+    uint8_t Estimate(size_t hash) const {
+        uint8_t result = UINT8_MAX;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            result = min(result, rows[i][Index(hash, i)]);
+        }
+        return result;
+    }
+
+private:
+    size_t Index(size_t hash, size_t row) const {
+        uint64_t mixed = (hash + row) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(mixed ^ (mixed >> 29)) & width_mask;
+    }
+
+    array<vector<uint8_t>, 4> rows;
+    size_t width_mask;
+    size_t reset_period;
+    size_t additions = 0;
+};
+
+// W-TinyLFU:      LRU- (1% ),  
+//    (SLRU:    ).   
+//    ,      ,
+//        .
+class WTinyLfuPolicy : public IEvictionPolicy {
+public:
+    explicit WTinyLfuPolicy(size_t max_memory)
+        : window_budget(max_memory / 100)
+        , protected_budget((max_memory - window_budget) * 4 / 5)
+        , main_budget(max_memory - window_budget)
+    {}
+
+    void Insert(CacheEntry& entry) override {
+        sketch.Add(entry.name_hash);
+        entry.queue = WINDOW;
+        window.PushFront(entry);
+    }
+
+    void Touch(CacheEntry& entry) override {
+        sketch.Add(entry.name_hash);
+        ListOf(entry).Unlink(entry);
+        if (entry.queue == PROBATION) {
+            entry.queue = PROTECTED;
+        }
+        ListOf(entry).PushFront(entry);
+        //       
+        while (protected_entries.GetBytes() > protected_budget) {
+            CacheEntry& demoted = protected_entries.Back();
+            protected_entries.Unlink(demoted);
+            demoted.queue = PROBATION;
+            probation.PushFront(demoted);
+        }
+    }
+
+    CacheEntry& Evict() override {
+        while (!window.Empty() && window.GetBytes() > window_budget) {
+            CacheEntry& candidate = window.Back();
+            const size_t main_bytes = probation.GetBytes() + protected_entries.GetBytes();
+            if (main_bytes + candidate.size <= main_budget) {
+                window.Unlink(candidate);
+                candidate.queue = PROBATION;
+                probation.PushFront(candidate);
+                continue;
+            }
+            //    ,     
+            if (probation.Empty() && protected_entries.Empty()) {
+                window.Unlink(candidate);
+                return candidate;
+            }
+            CacheEntry& victim = MainVictim();
+            if (sketch.Estimate(candidate.name_hash) > sketch.Estimate(victim.name_hash)) {
+                ListOf(victim).Unlink(victim);
+                return victim;
+            }
+            window.Unlink(candidate);
+            return candidate;
+        }
+        if (!probation.Empty() || !protected_entries.Empty()) {
+            CacheEntry& victim = MainVictim();
+            ListOf(victim).Unlink(victim);
+            return victim;
+        }
+        CacheEntry& oldest = window.Back();
+        window.Unlink(oldest);
+        return oldest;
+    }
+
+    void Clear() override {
+        window.Clear();
+        probation.Clear();
+        protected_entries.Clear();
+    }
+
+    size_t GetOverhead() const override {
+        return sketch.GetMemory();
+    }
+
+private:
+    enum Queue : uint8_t { WINDOW, PROBATION, PROTECTED };
+
+    EntryList& ListOf(const CacheEntry& entry) {
+        switch (entry.queue) {
+        case WINDOW:
+            return window;
+        case PROBATION:
+            return probation;
+        default:
+            return protected_entries;
+        }
+    }
+
+    CacheEntry& MainVictim() {
+        return probation.Empty() ? protected_entries.Back() : probation.Back();
+    }
+
+    size_t window_budget;
+    size_t protected_budget;
+    size_t main_budget;
+    EntryList window;
+    EntryList probation;
+    EntryList protected_entries;
+    FrequencySketch sketch;
+};
+
+// S3-FIFO:       (10% ). ,  
+//    ,     , 
+// ,      -.   
+//     .      
+//    .
+class S3FifoPolicy : public IEvictionPolicy {
+public:
+    explicit S3FifoPolicy(size_t max_memory)
+        : small_budget(max_memory / 10)
+    {}
+
+    void Insert(CacheEntry& entry) override {
+        entry.frequency = 0;
+        auto ghost_it = ghost_positions.find(entry.name_hash);
+        if (ghost_it != ghost_positions.end()) {
+            ghost_order.erase(ghost_it->second);
+            ghost_positions.erase(ghost_it);
+            entry.queue = MAIN;
+            main.PushFront(entry);
+        }
+        else {
+            entry.queue = SMALL;
+            small.PushFront(entry);
+        }
+        ++entry_count;
+    }
+
+    void Touch(CacheEntry& entry) override {
+        entry.frequency = min<uint8_t>(entry.frequency + 1, 3);
+    }
+
+    size_t GetGhostCount() const {
+        return ghost_order.size();
+    }
+
+    CacheEntry& Evict() override {
+        while (true) {
+            if (!small.Empty() && (small.GetBytes() > small_budget || main.Empty())) {
+                CacheEntry& oldest = small.Back();
+                small.Unlink(oldest);
+                if (oldest.frequency > 1) {
+                    oldest.queue = MAIN;
+                    oldest.frequency = 0;
+                    main.PushFront(oldest);
+                    continue;
+                }
+                RememberGhost(oldest.name_hash);
+                --entry_count;
+                return oldest;
+            }
+            CacheEntry& oldest = main.Back();
+            main.Unlink(oldest);
+            if (oldest.frequency > 0) {
+                --oldest.frequency;
+                main.PushFront(oldest);
+                continue;
+            }
+            --entry_count;
+            return oldest;
+        }
+    }
+
+    void Clear() override {
+        small.Clear();
+        main.Clear();
+        entry_count = 0;
+    }
+
+    //          
+    size_t GetOverhead() const override {
+        return ghost_order.size() * (sizeof(size_t) + 2 * sizeof(void*))
+            + ghost_positions.size() * (sizeof(pair<const size_t, list<size_t>::iterator>) + 2 * sizeof(void*))
+            + ghost_positions.bucket_count() * sizeof(void*);
+    }
+
+private:
+    enum Queue : uint8_t { SMALL, MAIN };
+
+    //     ,    
+    void RememberGhost(size_t hash) {
+        auto it = ghost_positions.find(hash);
+        if (it != ghost_positions.end()) {
+            ghost_order.splice(ghost_order.end(), ghost_order, it->second);
+        }
+        else {
+            ghost_positions[hash] = ghost_order.insert(ghost_order.end(), hash);
+        }
+        while (ghost_order.size() > max<size_t>(entry_count, 1)) {
+            ghost_positions.erase(ghost_order.front());
+            ghost_order.pop_front();
+        }
+    }
+
+    size_t small_budget;
+    size_t entry_count = 0;
+    EntryList small;
+    EntryList main;
+    //     ,    
+    list<size_t> ghost_order;
+    unordered_map<size_t, list<size_t>::iterator> ghost_positions;
+};
+
+// GreedyDual-Size-Frequency:    L +  *  / ,
+//   -   ,  L -  
+//  ,       
+//  .     .  
+//  ,      -  ,
+//   .   FrequencySketch,    
+//  ,       .
+class GdsfPolicy : public IEvictionPolicy {
+public:
+    explicit GdsfPolicy(size_t max_memory)
+        : max_memory(max_memory)
+    {}
+
+    bool Admit(const CacheEntry& entry, size_t bytes_to_free) override {
+        sketch.Add(entry.name_hash);
+        if (entry.size > max_memory) {
+            return false;
+        }
+        const double priority = GetPriority(entry);
+        size_t freed = 0;
+        for (auto it = queue.begin(); it != queue.end() && freed < bytes_to_free; ++it) {
+            if (it->first > priority) {
+                return false;
+            }
+            freed += it->second->size;
+        }
+        return true;
+    }
+
+    void Insert(CacheEntry& entry) override {
+        Push(entry);
+    }
+
+    void Touch(CacheEntry& entry) override {
+        sketch.Add(entry.name_hash);
+        queue.erase({ entry.priority, &entry });
+        Push(entry);
+    }
+
+    CacheEntry& Evict() override {
+        auto [priority, entry] = *queue.begin();
+        queue.erase(queue.begin());
+        clock = priority;
+        return *entry;
+    }
+
+    void Clear() override {
+        queue.clear();
+    }
+
+    //  -  - ,    
+    size_t GetOverhead() const override {
+        return queue.size() * (sizeof(pair<double, CacheEntry*>) + 4 * sizeof(void*)) + sketch.GetMemory();
+    }
+
+private:
+    double GetPriority(const CacheEntry& entry) const {
+        const double frequency = max<uint8_t>(sketch.Estimate(entry.name_hash), 1);
+        return clock + frequency * entry.cost / max<size_t>(entry.size, 1);
+    }
+
+    void Push(CacheEntry& entry) {
+        entry.priority = GetPriority(entry);
+        queue.insert({ entry.priority, &entry });
+    }
+
+    size_t max_memory;
+    double clock = 0;
+    set<pair<double, CacheEntry*>> queue;
+    FrequencySketch sketch;
+};
+
+inline unique_ptr<IEvictionPolicy> MakeEvictionPolicy(ICache::EvictionPolicy policy, size_t max_memory) {
+    switch (policy) {
+    case ICache::EvictionPolicy::W_TINY_LFU:
+        return make_unique<WTinyLfuPolicy>(max_memory);
+    case ICache::EvictionPolicy::S3_FIFO:
+        return make_unique<S3FifoPolicy>(max_memory);
+    case ICache::EvictionPolicy::GDSF:
+        return make_unique<GdsfPolicy>(max_memory);
+    default:
+        return make_unique<LruPolicy>();
+    }
+}
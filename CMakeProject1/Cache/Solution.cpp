@@ -1,68 +1,329 @@
 #include "Common.h"
+#include "EvictionPolicy.h"
+#include "ThreadPool.h"
+#include "CacheStats.h"
+#include "DiskTier.h"
+#include "BackgroundEvictor.h"
 #include <unordered_map>
 #include <mutex>
-#include <shared_mutex>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <future>
+#include <chrono>
 #include <algorithm>
-#include <set>
 
 using namespace std;
 
-class LruCache : public ICache {
+//          
+//  
+class CacheShard {
 public:
-    LruCache(
-        shared_ptr<IBooksUnpacker> books_unpacker,
-        const Settings& settings
-    )
-        : books_unpacker(books_unpacker)
-        , settings(settings)
-    {
-        //  
+    using BookPtr = ICache::BookPtr;
+    //         
+    using EvictedBooks = vector<pair<BookPtr, double>>;
+
+    //    hard_memory_limit  max_memory
+    CacheShard(size_t max_memory, size_t hard_memory_limit, bool account_overhead,
+        ICache::EvictionPolicy eviction_policy, CacheStatistics& statistics,
+        DiskTier* disk_tier, BackgroundEvictor* evictor)
+        : max_memory(max_memory)
+        , hard_memory_limit(hard_memory_limit)
+        , low_memory(max_memory - max_memory / 10)
+        , account_overhead(account_overhead)
+        , policy(MakeEvictionPolicy(eviction_policy, max_memory))
+        , statistics(statistics)
+        , disk_tier(disk_tier)
+        , evictor(evictor)
+    {}
+
+    CacheShard(const CacheShard&) = delete;
+    CacheShard& operator=(const CacheShard&) = delete;
+
+    //         :
+    //   ,    .
+    //  (touch == false)     .
+    BookPtr GetBook(const string& book_name, size_t name_hash, IBooksUnpacker& books_unpacker,
+        bool touch = true) {
+        promise<BookPtr> unpacked;
+        {
+            //    ,  
+            //  
+            unique_lock lock(mutex_);
+            auto it = entries.find(book_name);
+            if (it != entries.end()) {
+                if (touch) {
+                    policy->Touch(it->second);
+                    statistics.AddHit();
+                }
+                return it->second.book;
+            }
+            if (touch) {
+                statistics.AddMiss();
+            }
+
+            auto [pending_it, inserted] = pending.try_emplace(book_name);
+            if (!inserted) {
+                auto pending_book = pending_it->second;
+                lock.unlock();
+                return pending_book.get();
+            }
+            pending_it->second = unpacked.get_future().share();
+        }
+
+        BookPtr book_ptr;
+        EvictedBooks evicted;
+        try {
+            //        
+            double unpack_cost = 1;
+            book_ptr = disk_tier ? disk_tier->Get(book_name, unpack_cost) : nullptr;
+            if (book_ptr) {
+                statistics.AddDiskHit();
+            }
+            else {
+                const auto unpack_start = chrono::steady_clock::now();
+                book_ptr = books_unpacker.UnpackBook(book_name);
+                const auto unpack_duration = chrono::steady_clock::now() - unpack_start;
+                statistics.AddUnpack(unpack_duration);
+                unpack_cost = max(1.0, chrono::duration<double, micro>(unpack_duration).count());
+            }
+            book_ptr = Insert(book_name, name_hash, move(book_ptr), unpack_cost, evicted);
+            unpacked.set_value(book_ptr);
+        }
+        catch (...) {
+            {
+                lock_guard lock(mutex_);
+                pending.erase(book_name);
+            }
+            unpacked.set_exception(current_exception());
+            throw;
+        }
+
+        //        
+        WriteToDisk(evicted);
+        return book_ptr;
     }
 
-    BookPtr GetBook(const string& book_name) override {
+    //     max_memory,    
+    // .   .
+    void EvictToLowWatermark() {
+        EvictedBooks evicted;
         {
-            shared_lock lock(mutex_);
-            auto it = pos_by_name.find(book_name);
-            if (it != pos_by_name.end()) {
-                int pos = it->second;
-                return cache[pos];
+            lock_guard lock(mutex_);
+            if (used_memory > max_memory) {
+                EvictWhileAbove(low_memory, evicted);
             }
         }
+        WriteToDisk(evicted);
+    }
+
+private:
+    // ,   ,   evicted,    .
+    // unpack_cost -    .
+    BookPtr Insert(const string& book_name, size_t name_hash, BookPtr book_ptr,
+        double unpack_cost, EvictedBooks& evicted) {
+        lock_guard lock(mutex_);
+        pending.erase(book_name);
 
-        auto book_ptr = books_unpacker->UnpackBook(book_name);
+        CacheEntry candidate;
+        candidate.size = GetChargedSize(book_name, *book_ptr);
+        candidate.name_hash = name_hash;
+        candidate.cost = unpack_cost;
+        const size_t free_memory = max_memory - min(used_memory, max_memory);
+        if (!policy->Admit(candidate, candidate.size - min(candidate.size, free_memory))) {
+            statistics.AddRejection();
+            return book_ptr;
+        }
 
-        unique_lock lock(mutex_);
-        if (book_ptr->GetContent().size() > settings.max_memory) {
-            pos_by_name.clear();
-            cache.clear();
+        const size_t book_size = candidate.size;
+        if (book_size > max_memory) {
+            policy->Clear();
+            statistics.AddEvictions(entries.size());
+            if (disk_tier) {
+                for (auto& [name, entry] : entries) {
+                    evicted.push_back({ move(entry.book), entry.cost });
+                }
+            }
+            entries.clear();
+            statistics.RemoveUsedMemory(used_memory);
+            used_memory = 0;
+            structure_memory = 0;
+            UpdateStructureMemory();
             return book_ptr;
         }
 
-        cache.insert(cache.begin(), shared_ptr<IBook>(move(book_ptr)));
-        for (auto& el: pos_by_name) {
-            el.second++;
+        //     ,      .
+        //  unordered_map    , 
+        //      .
+        CacheEntry& entry = entries[book_name];
+        entry = candidate;
+        entry.book = book_ptr;
+        policy->Insert(entry);
+        used_memory += book_size;
+        statistics.AddUsedMemory(book_size);
+
+        //       
+        EvictWhileAbove(hard_memory_limit, evicted);
+        if (evictor && used_memory > max_memory) {
+            evictor->Wake();
+        }
+        return book_ptr;
+    }
+
+    //         ,
+    //      
+    void EvictWhileAbove(size_t memory_limit, EvictedBooks& evicted) {
+        UpdateStructureMemory();
+        while (used_memory > memory_limit && !entries.empty()) {
+            CacheEntry& victim = policy->Evict();
+            used_memory -= victim.size;
+            statistics.RemoveUsedMemory(victim.size);
+            statistics.AddEvictions(1);
+            if (disk_tier) {
+                evicted.push_back({ victim.book, victim.cost });
+            }
+            entries.erase(entries.find(victim.book->GetName()));
+            UpdateStructureMemory();
+        }
+    }
+
+    //   used_memory,    
+    //   -,    
+    void UpdateStructureMemory() {
+        if (!account_overhead) {
+            return;
         }
+        const size_t memory = policy->GetOverhead() + entries.bucket_count() * sizeof(void*);
+        used_memory = used_memory - structure_memory + memory;
+        statistics.RemoveUsedMemory(structure_memory);
+        statistics.AddUsedMemory(memory);
+        structure_memory = memory;
+    }
 
+    void WriteToDisk(const EvictedBooks& evicted) {
+        for (const auto& [book, unpack_cost] : evicted) {
+            disk_tier->Put(*book, unpack_cost);
+        }
+    }
 
-        pos_by_name[book_name] = 0;
-        total_used_memory += (int)cache[0]->GetContent().size();
-        while (total_used_memory > settings.max_memory) {
-            total_used_memory -= cache.back()->GetContent().size();
-            pos_by_name.erase(cache.back()->GetName());
-            cache.pop_back();
+    //      -, 
+    //  ,  -,      
+    // shared_ptr.     .
+    size_t GetChargedSize(const string& book_name, const IBook& book) const {
+        const size_t content_size = book.GetContent().size();
+        if (!account_overhead) {
+            return content_size;
+        }
+        return content_size + book_name.size() + book.GetName().size() + ENTRY_OVERHEAD;
+    }
+
+    //   ,       
+    //     .   shared_ptr, 
+    //  unique_ptr, -    ,    .
+    static constexpr size_t ENTRY_OVERHEAD = sizeof(pair<const string, CacheEntry>) + 2 * sizeof(void*)
+        + sizeof(void*) + 2 * sizeof(string)
+        + 4 * sizeof(void*);
+
+    unordered_map<string, CacheEntry> entries;
+    // ,   
+    unordered_map<string, shared_future<BookPtr>> pending;
+    //   structure_memory,   account_overhead
+    size_t used_memory = 0;
+    size_t structure_memory = 0;
+    size_t max_memory;
+    size_t hard_memory_limit;
+    //     
+    size_t low_memory;
+    bool account_overhead;
+    unique_ptr<IEvictionPolicy> policy;
+    CacheStatistics& statistics;
+    //  ,    ,  nullptr
+    DiskTier* disk_tier;
+    //    nullptr
+    BackgroundEvictor* evictor;
+    mutex mutex_;
+};
+
+class ShardedCache : public ICache {
+public:
+    ShardedCache(
+        shared_ptr<IBooksUnpacker> books_unpacker,
+        const Settings& settings
+    )
+        : books_unpacker(books_unpacker)
+        , settings(settings)
+    {
+        if (!settings.disk_directory.empty() && settings.max_disk_memory > 0) {
+            disk_tier = make_unique<DiskTier>(settings.disk_directory, settings.max_disk_memory);
+        }
+        const bool background_eviction = settings.hard_memory_limit > settings.max_memory;
+        if (background_eviction) {
+            //     
+            evictor = make_unique<BackgroundEvictor>([this] {
+                for (auto& shard : shards) {
+                    shard->EvictToLowWatermark();
+                }
+            });
+        }
+
+        //     ,   
+        const size_t shard_count = max<size_t>(settings.shard_count, 1);
+        const auto share = [shard_count](size_t memory, size_t i) {
+            return memory / shard_count + (i < memory % shard_count ? 1 : 0);
+        };
+        for (size_t i = 0; i < shard_count; ++i) {
+            const size_t max_memory = share(settings.max_memory, i);
+            shards.push_back(make_unique<CacheShard>(max_memory,
+                background_eviction ? share(settings.hard_memory_limit, i) : max_memory,
+                settings.account_overhead, settings.eviction_policy, statistics,
+                disk_tier.get(), evictor.get()));
+        }
+    }
+
+    BookPtr GetBook(const string& book_name) override {
+        const size_t name_hash = hash<string>{}(book_name);
+        return shards[name_hash % shards.size()]->GetBook(book_name, name_hash, *books_unpacker);
+    }
+
+    Stats GetStats() const override {
+        Stats stats = statistics.GetSnapshot();
+        if (disk_tier) {
+            stats.disk_used_memory = disk_tier->GetUsedBytes();
+        }
+        return stats;
+    }
+
+    void Prefetch(const vector<string>& book_names) override {
+        if (settings.prefetch_threads == 0) {
+            return;
+        }
+        call_once(prefetch_pool_created, [this] {
+            prefetch_pool = make_unique<ThreadPool>(settings.prefetch_threads);
+        });
+        for (const auto& book_name : book_names) {
+            prefetch_pool->Submit([this, book_name] {
+                const size_t name_hash = hash<string>{}(book_name);
+                try {
+                    shards[name_hash % shards.size()]->GetBook(book_name, name_hash, *books_unpacker, false);
+                }
+                catch (...) {
+                    //    ,     GetBook
+                }
+            });
         }
-        return cache[0];
     }
 
 private:
-    vector<BookPtr> cache;
-    unordered_map<string, int> pos_by_name;
-    int total_used_memory = 0;
+    CacheStatistics statistics;
+    unique_ptr<DiskTier> disk_tier;
+    vector<unique_ptr<CacheShard>> shards;
+    //   
+    unique_ptr<BackgroundEvictor> evictor;
     shared_ptr<IBooksUnpacker> books_unpacker;
     Settings settings;
-    shared_mutex mutex_;
+    once_flag prefetch_pool_created;
+    //    Prefetch   ,    
+    unique_ptr<ThreadPool> prefetch_pool;
 };
 
 
@@ -70,5 +331,5 @@ unique_ptr<ICache> MakeCache(
     shared_ptr<IBooksUnpacker> books_unpacker,
     const ICache::Settings& settings
 ) {
-    return make_unique<LruCache>(books_unpacker, settings);
+    return make_unique<ShardedCache>(books_unpacker, settings);
 }
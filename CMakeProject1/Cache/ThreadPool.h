@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//   ,     .
+//     ,  .
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count) {
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([this] { Work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            lock_guard lock(mutex_);
+            stopped = true;
+            tasks.clear();
+        }
+        task_added.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void Submit(function<void()> task) {
+        {
+            lock_guard lock(mutex_);
+            tasks.push_back(move(task));
+        }
+        task_added.notify_one();
+    }
+
+private:
+    void Work() {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock lock(mutex_);
+                task_added.wait(lock, [this] { return stopped || !tasks.empty(); });
+                if (stopped) {
+                    return;
+                }
+                task = move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    vector<thread> threads;
+    deque<function<void()>> tasks;
+    bool stopped = false;
+    mutex mutex_;
+    condition_variable task_added;
+};
@@ -1,11 +1,14 @@
 #include "Common.h"
+#include "EvictionPolicy.h"
 #include "test_runner.h"
 
 #include <atomic>
+#include <filesystem>
 #include <future>
 #include <numeric>
 #include <random>
 #include <sstream>
+#include <thread>
 
 using namespace std;
 
@@ -78,6 +81,16 @@ private:
     atomic<int> unpacked_books_count_ = 0;
 };
 
+//   ,      
+//  
+class SlowBooksUnpacker : public BooksUnpacker {
+public:
+    unique_ptr<IBook> UnpackBook(const string& book_name) override {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        return BooksUnpacker::UnpackBook(book_name);
+    }
+};
+
 struct Library {
     vector<string> book_names;
     unordered_map<string, unique_ptr<IBook>> content;
@@ -105,14 +118,20 @@ void TestUnpacker(const Library& lib) {
 
 
 void TestMaxMemory(const Library& lib) {
-    auto unpacker = make_shared<BooksUnpacker>();
-    ICache::Settings settings;
-    settings.max_memory = lib.size_in_bytes / 2;
-    auto cache = MakeCache(unpacker, settings);
-
-    for (const auto& [name, book] : lib.content) {
-        cache->GetBook(name);
-        ASSERT(unpacker->GetMemoryUsedByBooks() <= settings.max_memory);
+    for (auto policy : { ICache::EvictionPolicy::LRU, ICache::EvictionPolicy::W_TINY_LFU,
+        ICache::EvictionPolicy::S3_FIFO, ICache::EvictionPolicy::GDSF }) {
+        auto unpacker = make_shared<BooksUnpacker>();
+        ICache::Settings settings;
+        settings.max_memory = lib.size_in_bytes / 2;
+        settings.eviction_policy = policy;
+        auto cache = MakeCache(unpacker, settings);
+
+        for (int round = 0; round < 3; ++round) {
+            for (const auto& [name, book] : lib.content) {
+                cache->GetBook(name);
+                ASSERT(unpacker->GetMemoryUsedByBooks() <= settings.max_memory);
+            }
+        }
     }
 }
 
@@ -135,6 +154,322 @@ void TestCaching(const Library& lib) {
 }
 
 
+void TestLruOrder(const Library&) {
+    auto unpacker = make_shared<BooksUnpacker>();
+    ICache::Settings settings;
+    //        
+    settings.max_memory = 2 * unpacker->UnpackBook("Book 1")->GetContent().size();
+    auto cache = MakeCache(unpacker, settings);
+
+    cache->GetBook("Book 1");
+    cache->GetBook("Book 2");
+    cache->GetBook("Book 1");
+    //  "Book 2",      
+    cache->GetBook("Book 3");
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), 4);
+    cache->GetBook("Book 1");
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), 4);
+    cache->GetBook("Book 2");
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), 5);
+}
+
+
+//         
+void TestScanResistance(const Library&) {
+    for (auto policy : { ICache::EvictionPolicy::W_TINY_LFU, ICache::EvictionPolicy::S3_FIFO }) {
+        auto unpacker = make_shared<BooksUnpacker>();
+        ICache::Settings settings;
+        settings.max_memory = 10 * unpacker->UnpackBook("Book 00")->GetContent().size();
+        settings.eviction_policy = policy;
+        auto cache = MakeCache(unpacker, settings);
+
+        const vector<string> hot_books = { "Book 00", "Book 01", "Book 02", "Book 03", "Book 04" };
+        for (int round = 0; round < 5; ++round) {
+            for (const auto& book_name : hot_books) {
+                cache->GetBook(book_name);
+            }
+        }
+        for (int i = 10; i < 50; ++i) {
+            cache->GetBook("Book " + to_string(i));
+        }
+
+        const int unpacked_count = unpacker->GetUnpackedBooksCount();
+        for (const auto& book_name : hot_books) {
+            ASSERT_EQUAL(cache->GetBook(book_name)->GetName(), book_name);
+        }
+        ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), unpacked_count);
+    }
+}
+
+
+//  ,    ,    
+void TestSizeAwareAdmission(const Library&) {
+    auto unpacker = make_shared<BooksUnpacker>();
+    ICache::Settings settings;
+    const size_t small_size = unpacker->UnpackBook("Book 0")->GetContent().size();
+    settings.max_memory = 10 * small_size;
+    settings.eviction_policy = ICache::EvictionPolicy::GDSF;
+    auto cache = MakeCache(unpacker, settings);
+
+    const vector<string> hot_books = { "Book 0", "Book 1", "Book 2", "Book 3", "Book 4" };
+    for (int round = 0; round < 20; ++round) {
+        for (const auto& book_name : hot_books) {
+            cache->GetBook(book_name);
+        }
+    }
+    const string huge_name(6 * small_size, 'x');
+    ASSERT_EQUAL(cache->GetBook(huge_name)->GetName(), huge_name);
+    ASSERT_EQUAL(cache->GetStats().rejections, size_t(1));
+
+    const int unpacked_count = unpacker->GetUnpackedBooksCount();
+    for (const auto& book_name : hot_books) {
+        cache->GetBook(book_name);
+    }
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), unpacked_count);
+}
+
+
+//          
+void TestDiskTier(const Library& lib) {
+    const auto directory = filesystem::temp_directory_path() / "cache_test_disk_tier";
+    auto unpacker = make_shared<BooksUnpacker>();
+    {
+        ICache::Settings settings;
+        settings.max_memory = lib.size_in_bytes / 4;
+        settings.disk_directory = directory.string();
+        settings.max_disk_memory = lib.size_in_bytes;
+        auto cache = MakeCache(unpacker, settings);
+
+        for (const auto& book_name : lib.book_names) {
+            cache->GetBook(book_name);
+        }
+        const int unpacked_count = unpacker->GetUnpackedBooksCount();
+        for (const auto& book_name : lib.book_names) {
+            const auto book = cache->GetBook(book_name);
+            ASSERT_EQUAL(book->GetName(), book_name);
+            ASSERT_EQUAL(book->GetContent(), unpacker->UnpackBook(book_name)->GetContent());
+        }
+        ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), unpacked_count + int(lib.book_names.size()));
+
+        const auto stats = cache->GetStats();
+        ASSERT(stats.disk_hits > 0);
+        ASSERT_EQUAL(stats.unpacks + stats.disk_hits, stats.misses);
+        ASSERT(stats.disk_used_memory <= settings.max_disk_memory);
+    }
+    //     
+    ASSERT(filesystem::is_empty(directory));
+    filesystem::remove(directory);
+}
+
+
+//       max_memory
+void TestOverheadAccounting(const Library& lib) {
+    auto unpacker = make_shared<BooksUnpacker>();
+    ICache::Settings settings;
+    settings.max_memory = lib.size_in_bytes;
+    settings.account_overhead = true;
+    size_t one_book_size = 0;
+    size_t two_books_size = 0;
+    {
+        auto cache = MakeCache(unpacker, settings);
+        cache->GetBook("Book 1");
+        one_book_size = cache->GetStats().used_memory;
+        ASSERT(one_book_size > unpacker->GetMemoryUsedByBooks());
+        cache->GetBook("Book 2");
+        two_books_size = cache->GetStats().used_memory;
+    }
+    {
+        //   W-TinyLFU    
+        settings.eviction_policy = ICache::EvictionPolicy::W_TINY_LFU;
+        auto cache = MakeCache(unpacker, settings);
+        cache->GetBook("Book 1");
+        ASSERT(cache->GetStats().used_memory > one_book_size);
+        settings.eviction_policy = ICache::EvictionPolicy::LRU;
+    }
+
+    //       
+    unpacker = make_shared<BooksUnpacker>();
+    settings.max_memory = two_books_size - 1;
+    auto cache = MakeCache(unpacker, settings);
+    cache->GetBook("Book 1");
+    cache->GetBook("Book 2");
+    cache->GetBook("Book 1");
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), 3);
+    ASSERT(cache->GetStats().used_memory <= settings.max_memory);
+}
+
+
+//   max_memory      
+//   hard_memory_limit
+void TestBackgroundEviction(const Library& lib) {
+    auto unpacker = make_shared<BooksUnpacker>();
+    ICache::Settings settings;
+    settings.max_memory = lib.size_in_bytes / 4;
+    settings.hard_memory_limit = lib.size_in_bytes / 2;
+    auto cache = MakeCache(unpacker, settings);
+
+    for (const auto& book_name : lib.book_names) {
+        cache->GetBook(book_name);
+        ASSERT(cache->GetStats().used_memory <= settings.hard_memory_limit);
+    }
+    for (int i = 0; i < 100 && cache->GetStats().used_memory > settings.max_memory; ++i) {
+        this_thread::sleep_for(10ms);
+    }
+    ASSERT(cache->GetStats().used_memory <= settings.max_memory);
+    ASSERT_EQUAL(cache->GetStats().used_memory, unpacker->GetMemoryUsedByBooks());
+}
+
+
+//   ,       , 
+// ,      
+void TestWindowLargerThanMain(const Library&) {
+    auto unpacker = make_shared<BooksUnpacker>();
+    const string large_name(974, 'x');
+    ICache::Settings settings;
+    settings.max_memory = unpacker->UnpackBook(large_name)->GetContent().size() + 5;
+    settings.eviction_policy = ICache::EvictionPolicy::W_TINY_LFU;
+    auto cache = MakeCache(unpacker, settings);
+
+    cache->GetBook(large_name);
+    ASSERT_EQUAL(cache->GetBook("Book 1")->GetName(), "Book 1");
+    ASSERT(cache->GetStats().used_memory <= settings.max_memory);
+    const int unpacked_count = unpacker->GetUnpackedBooksCount();
+    cache->GetBook("Book 1");
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), unpacked_count);
+}
+
+
+//     , GDSF    ,
+//      
+void TestWorkingSetShift(const Library&) {
+    auto unpacker = make_shared<BooksUnpacker>();
+    ICache::Settings settings;
+    settings.max_memory = 3 * unpacker->UnpackBook("Book 0")->GetContent().size();
+    settings.eviction_policy = ICache::EvictionPolicy::GDSF;
+    auto cache = MakeCache(unpacker, settings);
+
+    for (int round = 0; round < 50; ++round) {
+        for (const string book_name : { "Book 0", "Book 1", "Book 2" }) {
+            cache->GetBook(book_name);
+        }
+    }
+    const int unpacked_count = unpacker->GetUnpackedBooksCount();
+    const int shift_rounds = 1000;
+    for (int round = 0; round < shift_rounds; ++round) {
+        cache->GetBook(round % 2 ? "Book 3" : "Book 4");
+    }
+    ASSERT(unpacker->GetUnpackedBooksCount() - unpacked_count < shift_rounds / 2);
+
+    const int shifted_count = unpacker->GetUnpackedBooksCount();
+    cache->GetBook("Book 3");
+    cache->GetBook("Book 4");
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), shifted_count);
+}
+
+
+// ,    S3-FIFO,     ,
+//         
+void TestS3FifoGhostBound(const Library&) {
+    const size_t capacity = 100;
+    S3FifoPolicy policy(capacity);
+    //   :       
+    //   ,   ,    
+    vector<CacheEntry> entries(capacity * 13 / 10 + 1);
+    vector<char> cached(entries.size());
+    size_t used_memory = 0;
+    for (size_t i = 0; i < 100000; ++i) {
+        const size_t book = i == 0 ? 0 : 1 + i % (entries.size() - 1);
+        if (cached[book]) {
+            policy.Touch(entries[book]);
+            continue;
+        }
+        entries[book] = CacheEntry{};
+        entries[book].size = 1;
+        entries[book].name_hash = book;
+        policy.Insert(entries[book]);
+        cached[book] = 1;
+        ++used_memory;
+        while (used_memory > capacity) {
+            cached[&policy.Evict() - entries.data()] = 0;
+            --used_memory;
+        }
+        ASSERT(policy.GetGhostCount() <= capacity);
+    }
+}
+
+
+void TestSingleUnpack(const Library& lib) {
+    auto unpacker = make_shared<SlowBooksUnpacker>();
+    ICache::Settings settings;
+    settings.max_memory = lib.size_in_bytes;
+    auto cache = MakeCache(unpacker, settings);
+
+    vector<future<void>> tasks;
+    for (int task_num = 0; task_num < 8; ++task_num) {
+        tasks.push_back(async(launch::async, [&cache, &lib] {
+            ASSERT_EQUAL(cache->GetBook(lib.book_names[0])->GetName(), lib.book_names[0]);
+        }));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), 1);
+}
+
+
+void TestPrefetch(const Library& lib) {
+    auto unpacker = make_shared<SlowBooksUnpacker>();
+    ICache::Settings settings;
+    settings.max_memory = lib.size_in_bytes;
+    settings.prefetch_threads = 2;
+    auto cache = MakeCache(unpacker, settings);
+
+    //        ,    
+    //   
+    cache->Prefetch({ lib.book_names[0], lib.book_names[1] });
+    const auto prefetched = [&] {
+        const auto stats = cache->GetStats();
+        return stats.unpacks == 2 && stats.used_memory == unpacker->GetMemoryUsedByBooks();
+    };
+    for (int i = 0; i < 500 && !prefetched(); ++i) {
+        this_thread::sleep_for(10ms);
+    }
+    ASSERT(prefetched());
+
+    ASSERT_EQUAL(cache->GetBook(lib.book_names[0])->GetName(), lib.book_names[0]);
+    ASSERT_EQUAL(cache->GetBook(lib.book_names[1])->GetName(), lib.book_names[1]);
+    ASSERT_EQUAL(cache->GetStats().hits, size_t(2));
+    ASSERT_EQUAL(unpacker->GetUnpackedBooksCount(), 2);
+}
+
+
+void TestStats(const Library& lib) {
+    auto unpacker = make_shared<BooksUnpacker>();
+    ICache::Settings settings;
+    settings.max_memory = lib.size_in_bytes / 2;
+    auto cache = MakeCache(unpacker, settings);
+
+    cache->GetBook(lib.book_names[0]);
+    cache->GetBook(lib.book_names[0]);
+    for (const auto& book_name : lib.book_names) {
+        cache->GetBook(book_name);
+    }
+
+    const auto stats = cache->GetStats();
+    ASSERT_EQUAL(stats.hits + stats.misses, lib.book_names.size() + 2);
+    ASSERT_EQUAL(stats.unpacks, stats.misses);
+    ASSERT_EQUAL(stats.unpacks, size_t(unpacker->GetUnpackedBooksCount()));
+    ASSERT(stats.evictions > 0);
+    ASSERT_EQUAL(stats.used_memory, unpacker->GetMemoryUsedByBooks());
+    size_t unpack_count = 0;
+    for (size_t count : stats.unpack_latency_buckets) {
+        unpack_count += count;
+    }
+    ASSERT_EQUAL(unpack_count, stats.unpacks);
+    ASSERT(stats.GetUnpackLatencyQuantile(0.5) <= stats.GetUnpackLatencyQuantile(0.99));
+}
+
+
 void TestSmallCache(const Library& lib) {
     auto unpacker = make_shared<BooksUnpacker>();
     ICache::Settings settings;
@@ -147,13 +482,28 @@ void TestSmallCache(const Library& lib) {
 }
 
 
-void TestAsync(const Library& lib) {
+void TestShardedMaxMemory(const Library& lib) {
+    auto unpacker = make_shared<BooksUnpacker>();
+    ICache::Settings settings;
+    settings.max_memory = lib.size_in_bytes / 2;
+    settings.shard_count = 4;
+    auto cache = MakeCache(unpacker, settings);
+
+    for (const auto& [name, book] : lib.content) {
+        cache->GetBook(name);
+        ASSERT(unpacker->GetMemoryUsedByBooks() <= settings.max_memory);
+    }
+}
+
+
+void TestAsync(const Library& lib, size_t shard_count) {
     static const int tasks_count = 10;
     static const int trials_count = 10000;
 
     auto unpacker = make_shared<BooksUnpacker>();
     ICache::Settings settings;
     settings.max_memory = lib.size_in_bytes - 1;
+    settings.shard_count = shard_count;
     auto cache = MakeCache(unpacker, settings);
 
     vector<future<void>> tasks;
@@ -208,8 +558,22 @@ int main() {
     RUN_CACHE_TEST(tr, TestUnpacker);
     RUN_CACHE_TEST(tr, TestMaxMemory);
     RUN_CACHE_TEST(tr, TestCaching);
+    RUN_CACHE_TEST(tr, TestLruOrder);
+    RUN_CACHE_TEST(tr, TestSingleUnpack);
+    RUN_CACHE_TEST(tr, TestScanResistance);
+    RUN_CACHE_TEST(tr, TestWindowLargerThanMain);
+    RUN_CACHE_TEST(tr, TestS3FifoGhostBound);
+    RUN_CACHE_TEST(tr, TestSizeAwareAdmission);
+    RUN_CACHE_TEST(tr, TestWorkingSetShift);
+    RUN_CACHE_TEST(tr, TestDiskTier);
+    RUN_CACHE_TEST(tr, TestOverheadAccounting);
+    RUN_CACHE_TEST(tr, TestBackgroundEviction);
+    RUN_CACHE_TEST(tr, TestPrefetch);
+    RUN_CACHE_TEST(tr, TestStats);
     RUN_CACHE_TEST(tr, TestSmallCache);
-    RUN_CACHE_TEST(tr, TestAsync);
+    RUN_CACHE_TEST(tr, TestShardedMaxMemory);
+    tr.RunTest([&lib] { TestAsync(lib, 1); }, "TestAsync");
+    tr.RunTest([&lib] { TestAsync(lib, 4); }, "TestAsyncSharded");
 
 #undef RUN_CACHE_TEST
     return 0;
@@ -0,0 +1,122 @@
+#include "Common.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+//        
+//     .    
+//   ,  ,     .
+//
+//   CacheReplay trace.txt [max_memory] [shard_count]
+
+struct Access {
+    string name;
+    size_t size;
+};
+
+class ReplayBook : public IBook {
+public:
+    ReplayBook(string name, size_t size)
+        : name_(move(name))
+        , content_(size, '*')
+    {}
+
+    const string& GetName() const override {
+        return name_;
+    }
+
+    const string& GetContent() const override {
+        return content_;
+    }
+
+private:
+    string name_;
+    string content_;
+};
+
+class ReplayUnpacker : public IBooksUnpacker {
+public:
+    explicit ReplayUnpacker(const unordered_map<string, size_t>& size_by_name)
+        : size_by_name_(size_by_name)
+    {}
+
+    unique_ptr<IBook> UnpackBook(const string& book_name) override {
+        ++unpacked_books_count_;
+        return make_unique<ReplayBook>(book_name, size_by_name_.at(book_name));
+    }
+
+    size_t GetUnpackedBooksCount() const {
+        return unpacked_books_count_;
+    }
+
+private:
+    const unordered_map<string, size_t>& size_by_name_;
+    size_t unpacked_books_count_ = 0;
+};
+
+vector<Access> ReadTrace(istream& input) {
+    const size_t DEFAULT_SIZE = 1 << 10;
+    vector<Access> trace;
+    for (string line; getline(input, line); ) {
+        if (line.empty()) {
+            continue;
+        }
+        const size_t tab = line.find('\t');
+        if (tab == string::npos) {
+            trace.push_back({ line, DEFAULT_SIZE });
+        }
+        else {
+            trace.push_back({ line.substr(0, tab), stoul(line.substr(tab + 1)) });
+        }
+    }
+    return trace;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "usage: CacheReplay trace.txt [max_memory] [shard_count]\n";
+        return 1;
+    }
+    ifstream input(argv[1]);
+    const auto trace = ReadTrace(input);
+
+    unordered_map<string, size_t> size_by_name;
+    size_t catalog_bytes = 0;
+    for (const auto& access : trace) {
+        if (size_by_name.emplace(access.name, access.size).second) {
+            catalog_bytes += access.size;
+        }
+    }
+
+    ICache::Settings settings;
+    settings.max_memory = argc > 2 ? stoul(argv[2]) : catalog_bytes / 10;
+    settings.shard_count = argc > 3 ? stoul(argv[3]) : 1;
+    cout << trace.size() << " accesses, " << size_by_name.size() << " books, "
+        << catalog_bytes << " bytes, max_memory " << settings.max_memory << "\n";
+
+    const pair<const char*, ICache::EvictionPolicy> policies[] = {
+        { "LRU", ICache::EvictionPolicy::LRU },
+        { "W-TinyLFU", ICache::EvictionPolicy::W_TINY_LFU },
+        { "S3-FIFO", ICache::EvictionPolicy::S3_FIFO },
+        { "GDSF", ICache::EvictionPolicy::GDSF }
+    };
+    for (const auto& [policy_name, policy] : policies) {
+        auto unpacker = make_shared<ReplayUnpacker>(size_by_name);
+        settings.eviction_policy = policy;
+        auto cache = MakeCache(unpacker, settings);
+        for (const auto& access : trace) {
+            cache->GetBook(access.name);
+        }
+        const size_t misses = unpacker->GetUnpackedBooksCount();
+        cout << setw(12) << left << policy_name << fixed << setprecision(2)
+            << 100.0 * (trace.size() - misses) / max<size_t>(trace.size(), 1) << "% hits, "
+            << misses << " misses\n";
+    }
+}
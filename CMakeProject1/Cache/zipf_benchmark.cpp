@@ -0,0 +1,219 @@
+#include "Common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//         
+//       ,  
+//   GetBook.     
+//  --min-size  --max-size,   --unpack-us .
+//
+//   CacheBenchmark [--threads N] [--requests N] [--books N] [--skew S]
+//       [--min-size B] [--max-size B] [--unpack-us U] [--max-memory B] [--shards N]
+
+struct BenchmarkOptions {
+    size_t threads = max(thread::hardware_concurrency(), 1u);
+    //   
+    size_t requests = 100000;
+    size_t books = 10000;
+    double skew = 0.99;
+    size_t min_size = 1 << 10;
+    size_t max_size = 1 << 16;
+    size_t unpack_us = 100;
+    //       
+    size_t max_memory = 0;
+    size_t shards = 16;
+};
+
+class BenchmarkBook : public IBook {
+public:
+    BenchmarkBook(string name, size_t size)
+        : name_(move(name))
+        , content_(size, '*')
+    {}
+
+    const string& GetName() const override {
+        return name_;
+    }
+
+    const string& GetContent() const override {
+        return content_;
+    }
+
+private:
+    string name_;
+    string content_;
+};
+
+class BenchmarkUnpacker : public IBooksUnpacker {
+public:
+    BenchmarkUnpacker(const vector<size_t>& sizes, chrono::microseconds latency)
+        : sizes_(sizes)
+        , latency_(latency)
+    {}
+
+    unique_ptr<IBook> UnpackBook(const string& book_name) override {
+        this_thread::sleep_for(latency_);
+        return make_unique<BenchmarkBook>(book_name, sizes_[stoul(book_name)]);
+    }
+
+private:
+    const vector<size_t>& sizes_;
+    chrono::microseconds latency_;
+};
+
+//    ,   ( + 1)^skew
+class ZipfGenerator {
+public:
+    ZipfGenerator(size_t count, double skew)
+        : cumulative(count)
+    {
+        double total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            total += 1 / pow(i + 1, skew);
+            cumulative[i] = total;
+        }
+        for (double& value : cumulative) {
+            value /= total;
+        }
+    }
+
+    size_t operator()(mt19937_64& generator) const {
+        const double value = uniform_real_distribution<double>(0, 1)(generator);
+        const auto it = lower_bound(cumulative.begin(), cumulative.end(), value);
+        return min<size_t>(it - cumulative.begin(), cumulative.size() - 1);
+    }
+
+private:
+    vector<double> cumulative;
+};
+
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const string_view name = argv[i];
+        const string value = argv[i + 1];
+        if (name == "--threads") {
+            options.threads = max<size_t>(stoul(value), 1);
+        }
+        else if (name == "--requests") {
+            options.requests = stoul(value);
+        }
+        else if (name == "--books") {
+            options.books = max<size_t>(stoul(value), 1);
+        }
+        else if (name == "--skew") {
+            options.skew = stod(value);
+        }
+        else if (name == "--min-size") {
+            options.min_size = max<size_t>(stoul(value), 1);
+        }
+        else if (name == "--max-size") {
+            options.max_size = stoul(value);
+        }
+        else if (name == "--unpack-us") {
+            options.unpack_us = stoul(value);
+        }
+        else if (name == "--max-memory") {
+            options.max_memory = stoul(value);
+        }
+        else if (name == "--shards") {
+            options.shards = max<size_t>(stoul(value), 1);
+        }
+        else {
+            cerr << "unknown option " << name << "\n";
+            exit(1);
+        }
+    }
+    options.max_size = max(options.max_size, options.min_size);
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    const BenchmarkOptions options = ParseOptions(argc, argv);
+
+    mt19937_64 size_generator(42);
+    uniform_real_distribution<double> log_size(log(double(options.min_size)), log(double(options.max_size)));
+    vector<size_t> sizes(options.books);
+    size_t catalog_bytes = 0;
+    for (size_t& size : sizes) {
+        size = clamp<size_t>(llround(exp(log_size(size_generator))), options.min_size, options.max_size);
+        catalog_bytes += size;
+    }
+    vector<string> book_names(options.books);
+    for (size_t i = 0; i < options.books; ++i) {
+        book_names[i] = to_string(i);
+    }
+    const ZipfGenerator zipf(options.books, options.skew);
+
+    ICache::Settings settings;
+    settings.max_memory = options.max_memory > 0 ? options.max_memory : catalog_bytes / 10;
+    settings.shard_count = options.shards;
+    cout << options.threads << " threads x " << options.requests << " requests, "
+        << options.books << " books, " << catalog_bytes << " bytes, zipf " << options.skew
+        << ", unpack " << options.unpack_us << " us, max_memory " << settings.max_memory << "\n";
+
+    const pair<const char*, ICache::EvictionPolicy> policies[] = {
+        { "LRU", ICache::EvictionPolicy::LRU },
+        { "W-TinyLFU", ICache::EvictionPolicy::W_TINY_LFU },
+        { "S3-FIFO", ICache::EvictionPolicy::S3_FIFO },
+        { "GDSF", ICache::EvictionPolicy::GDSF }
+    };
+    for (const auto& [policy_name, policy] : policies) {
+        auto unpacker = make_shared<BenchmarkUnpacker>(sizes, chrono::microseconds(options.unpack_us));
+        settings.eviction_policy = policy;
+        auto cache = MakeCache(unpacker, settings);
+
+        //  GetBook  ,    
+        vector<vector<int64_t>> latencies(options.threads);
+        const auto start = chrono::steady_clock::now();
+        {
+            vector<jthread> threads;
+            for (size_t thread_index = 0; thread_index < options.threads; ++thread_index) {
+                threads.emplace_back([&, thread_index] {
+                    mt19937_64 generator(thread_index);
+                    auto& thread_latencies = latencies[thread_index];
+                    thread_latencies.reserve(options.requests);
+                    for (size_t i = 0; i < options.requests; ++i) {
+                        const string& book_name = book_names[zipf(generator)];
+                        const auto request_start = chrono::steady_clock::now();
+                        cache->GetBook(book_name);
+                        thread_latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(
+                            chrono::steady_clock::now() - request_start).count());
+                    }
+                });
+            }
+        }
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        vector<int64_t> all_latencies;
+        for (const auto& thread_latencies : latencies) {
+            all_latencies.insert(all_latencies.end(), thread_latencies.begin(), thread_latencies.end());
+        }
+        const auto quantile = [&all_latencies](double q) {
+            if (all_latencies.empty()) {
+                return 0.0;
+            }
+            auto nth = all_latencies.begin() + static_cast<ptrdiff_t>(q * (all_latencies.size() - 1));
+            nth_element(all_latencies.begin(), nth, all_latencies.end());
+            return *nth / 1000.0;
+        };
+
+        const auto stats = cache->GetStats();
+        cout << setw(12) << left << policy_name << fixed << setprecision(0)
+            << all_latencies.size() / elapsed.count() << " ops/s, " << setprecision(2)
+            << 100.0 * stats.hits / max<size_t>(stats.hits + stats.misses, 1) << "% hits, p50 "
+            << quantile(0.5) << " us, p99 " << quantile(0.99) << " us\n";
+    }
+}